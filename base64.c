@@ -10,6 +10,8 @@
 #define LOG_ENABLE_DBG 0
 #include "log.h"
 #include "debug.h"
+#include "macros.h"
+#include "util.h"
 
 enum {
     P = 1 << 6, // Padding byte (=)
@@ -95,6 +97,180 @@ invalid:
     return NULL;
 }
 
+/*
+ * Decodes 16 input bytes into 12 output bytes. All lookups are done
+ * up front, and validated with a single test, allowing the compiler
+ * to unroll (and vectorize) the loops.
+ *
+ * Returns false if any of the input bytes is padding, or not part of
+ * the alphabet. ‘out’ is undefined in this case.
+ */
+static inline bool
+decode_block16(const uint8_t *restrict in, uint8_t *restrict out)
+{
+    uint8_t v[16];
+    unsigned u = 0;
+
+    for (size_t i = 0; i < 16; i++) {
+        v[i] = reverse_lookup[in[i]];
+        u |= v[i];
+    }
+
+    if (unlikely(u & (P | I)))
+        return false;
+
+    for (size_t i = 0, o = 0; i < 16; i += 4, o += 3) {
+        uint32_t x = v[i + 0] << 18 | v[i + 1] << 12 | v[i + 2] << 6 | v[i + 3];
+        out[o + 0] = (x >> 16) & 0xff;
+        out[o + 1] = (x >>  8) & 0xff;
+        out[o + 2] = (x >>  0) & 0xff;
+    }
+
+    return true;
+}
+
+size_t
+base64_decode_stream(struct base64_decoder *dec, const char *s, size_t len,
+                     uint8_t *out, size_t *out_len)
+{
+    const uint8_t *in = (const uint8_t *)s;
+    size_t i = 0;
+    size_t o = 0;
+
+    while (i < len) {
+        /* Fast path: whole blocks, no partial group carried over */
+        if (dec->count == 0 && !dec->padded) {
+            while (i + 16 <= len && decode_block16(&in[i], &out[o])) {
+                i += 16;
+                o += 12;
+            }
+
+            if (i >= len)
+                break;
+        }
+
+        /* Slow path: one byte at a time (tail, padding and errors) */
+        unsigned v = reverse_lookup[in[i]];
+        if (v & I)
+            break;
+
+        i++;
+
+        if (unlikely(dec->padded)) {
+            /* Data after padding */
+            dec->invalid = true;
+            continue;
+        }
+
+        dec->group[dec->count++] = v;
+        if (dec->count < 4)
+            continue;
+
+        dec->count = 0;
+
+        unsigned a = dec->group[0];
+        unsigned b = dec->group[1];
+        unsigned c = dec->group[2];
+        unsigned d = dec->group[3];
+        size_t count = 3;
+
+        if (unlikely((a | b | c | d) & P)) {
+            if ((a | b) & P || (c & P && !(d & P)))
+                dec->invalid = true;
+
+            dec->padded = true;
+            count = c & P ? 1 : 2;
+
+            a &= 63;
+            b &= 63;
+            c &= 63;
+            d &= 63;
+        }
+
+        uint32_t x = a << 18 | b << 12 | c << 6 | d << 0;
+        out[o++] = (x >> 16) & 0xff;
+        if (count >= 2)
+            out[o++] = (x >> 8) & 0xff;
+        if (count >= 3)
+            out[o++] = (x >> 0) & 0xff;
+    }
+
+    *out_len = o;
+    return i;
+}
+
+bool
+base64_decode_stream_finish(const struct base64_decoder *dec)
+{
+    return !dec->invalid && dec->count == 0;
+}
+
+UNITTEST
+{
+    const char *encoded =
+        "Zm9vIGlzIGEgZmFzdCwgbGlnaHR3ZWlnaHQgYW5kIG1pbmltYWxpc3RpYyBXYXls"
+        "YW5kIHRlcm1pbmFsIGVtdWxhdG9yLg==";
+    const char *decoded =
+        "foo is a fast, lightweight and minimalistic Wayland "
+        "terminal emulator.";
+
+    const size_t encoded_len = strlen(encoded);
+    const size_t decoded_len = strlen(decoded);
+
+    /* Feed the decoder with differently sized chunks */
+    for (size_t chunk = 1; chunk <= encoded_len; chunk++) {
+        struct base64_decoder dec = {0};
+        uint8_t out[BASE64_DECODED_MAX(128)];
+        size_t total = 0;
+
+        for (size_t i = 0; i < encoded_len; i += chunk) {
+            size_t left = min(chunk, encoded_len - i);
+            size_t out_len;
+            size_t consumed = base64_decode_stream(
+                &dec, &encoded[i], left, &out[total], &out_len);
+
+            xassert(consumed == left);
+            total += out_len;
+        }
+
+        xassert(base64_decode_stream_finish(&dec));
+        xassert(total == decoded_len);
+        xassert(memcmp(out, decoded, decoded_len) == 0);
+    }
+
+    /* Decoding stops at the first byte not in the alphabet */
+    {
+        struct base64_decoder dec = {0};
+        uint8_t out[BASE64_DECODED_MAX(16)];
+        size_t out_len;
+        size_t consumed = base64_decode_stream(
+            &dec, "Zm9vYmFy\033\\", 10, out, &out_len);
+
+        xassert(consumed == 8);
+        xassert(out_len == 6);
+        xassert(memcmp(out, "foobar", 6) == 0);
+        xassert(base64_decode_stream_finish(&dec));
+    }
+
+    /* Incomplete group */
+    {
+        struct base64_decoder dec = {0};
+        uint8_t out[BASE64_DECODED_MAX(16)];
+        size_t out_len;
+        base64_decode_stream(&dec, "Zm9vYmF", 7, out, &out_len);
+        xassert(!base64_decode_stream_finish(&dec));
+    }
+
+    /* Data after padding */
+    {
+        struct base64_decoder dec = {0};
+        uint8_t out[BASE64_DECODED_MAX(16)];
+        size_t out_len;
+        base64_decode_stream(&dec, "Zm8=Zm8=", 8, out, &out_len);
+        xassert(!base64_decode_stream_finish(&dec));
+    }
+}
+
 char *
 base64_encode(const uint8_t *data, size_t size)
 {
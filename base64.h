@@ -2,7 +2,36 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 char *base64_decode(const char *s);
 char *base64_encode(const uint8_t *data, size_t size);
 void base64_encode_final(const uint8_t *data, size_t size, char result[4]);
+
+/*
+ * Incremental decoder, for data received in chunks.
+ *
+ * Initialize with ‘= {0}’. Each call to base64_decode_stream()
+ * decodes as much as possible of ‘s’, carrying partial 4-byte
+ * groups over to the next call. Decoding stops at the first byte
+ * that isn’t part of the base64 alphabet; the number of *consumed*
+ * input bytes is returned, and the number of decoded bytes written
+ * to ‘out’ is stored in ‘out_len’.
+ *
+ * ‘out’ must have room for at least BASE64_DECODED_MAX(len) bytes.
+ */
+struct base64_decoder {
+    uint8_t group[4];
+    uint8_t count;
+    bool padded;   /* Padding has been seen; no more data allowed */
+    bool invalid;
+};
+
+#define BASE64_DECODED_MAX(len) (((len) / 4 + 1) * 3)
+
+size_t base64_decode_stream(
+    struct base64_decoder *dec, const char *s, size_t len,
+    uint8_t *out, size_t *out_len);
+
+/* Returns false if the stream was invalid, or ended mid-group */
+bool base64_decode_stream_finish(const struct base64_decoder *dec);
@@ -29,3 +29,35 @@ struct client_data {
 } __attribute__((packed));
 
 _Static_assert(sizeof(struct client_data) == 10, "protocol struct size error");
+
+/*
+ * Control requests are sent *instead* of the regular setup packet,
+ * and are recognized by CLIENT_CONTROL_REQUEST being set in the
+ * initial length word. The server responds with a uint32_t length,
+ * followed by that many bytes of response data, and then closes the
+ * connection.
+ */
+#define CLIENT_CONTROL_REQUEST (1u << 31)
+#define CLIENT_CONTROL_VERSION 2
+
+/*
+ * All responses are JSON documents. The memory management commands
+ * (trim, compact, drop-caches) respond with the affected terminals’
+ * statistics, as they look *after* the command has been executed.
+ */
+enum client_control_command {
+    CLIENT_CONTROL_STATS,        /* Runtime statistics */
+    CLIENT_CONTROL_LIST,         /* ID, PID, title etc of all terminals */
+    CLIENT_CONTROL_TRIM,         /* Free scrollback, keeping ‘arg’ lines */
+    CLIENT_CONTROL_COMPACT,      /* Release unused row memory */
+    CLIENT_CONTROL_DROP_CACHES,  /* Custom glyphs, scaled sixels */
+};
+
+struct client_control {
+    uint16_t version;
+    uint16_t command;
+    uint32_t terminal_id;  /* 0 means all terminals */
+    uint32_t arg;          /* Command specific */
+} __attribute__((packed));
+
+_Static_assert(sizeof(struct client_control) == 12, "protocol struct size error");
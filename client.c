@@ -27,6 +27,23 @@
 
 extern char **environ;
 
+/* Long-only options */
+enum {
+    OPT_STATS = 256,
+    OPT_CONTROL,
+};
+
+static const struct {
+    const char *name;
+    enum client_control_command command;
+} control_commands[] = {
+    {"stats", CLIENT_CONTROL_STATS},
+    {"list", CLIENT_CONTROL_LIST},
+    {"trim", CLIENT_CONTROL_TRIM},
+    {"compact", CLIENT_CONTROL_COMPACT},
+    {"drop-caches", CLIENT_CONTROL_DROP_CACHES},
+};
+
 struct string {
     size_t len;
     char *str;
@@ -62,6 +79,141 @@ sendall(int sock, const void *_buf, size_t len)
     return len;
 }
 
+static ssize_t
+recvall(int sock, void *_buf, size_t len)
+{
+    uint8_t *buf = _buf;
+    size_t left = len;
+
+    while (left > 0) {
+        ssize_t r = recv(sock, buf, left, 0);
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            return r;
+        }
+
+        if (r == 0)
+            break;
+
+        buf += r;
+        left -= r;
+    }
+
+    return len - left;
+}
+
+static bool
+parse_control_number(const char *s, const char *what, bool allow_all,
+                     uint32_t *value)
+{
+    if (allow_all && strcmp(s, "all") == 0) {
+        *value = 0;
+        return true;
+    }
+
+    errno = 0;
+    char *end = NULL;
+    unsigned long v = strtoul(s, &end, 10);
+
+    if (errno != 0 || *end != '\0' || end == s || v > UINT32_MAX) {
+        fprintf(stderr, "error: %s: invalid %s\n", s, what);
+        return false;
+    }
+
+    *value = v;
+    return true;
+}
+
+/*
+ * Parses “COMMAND [ID [LINES]]”, where ID is a terminal ID (as
+ * printed by the ‘list’ command), or ‘all’.
+ */
+static bool
+parse_control_command(int argc, char *const *argv, struct client_control *ctrl)
+{
+    if (argc < 1) {
+        fprintf(stderr, "error: --control: missing command\n");
+        return false;
+    }
+
+    size_t i;
+    for (i = 0; i < ALEN(control_commands); i++) {
+        if (strcmp(argv[0], control_commands[i].name) == 0)
+            break;
+    }
+
+    if (i >= ALEN(control_commands)) {
+        fprintf(stderr, "error: --control: %s: invalid command, must be one of:", argv[0]);
+        for (i = 0; i < ALEN(control_commands); i++)
+            fprintf(stderr, " %s", control_commands[i].name);
+        fprintf(stderr, "\n");
+        return false;
+    }
+
+    const int max_args = control_commands[i].command == CLIENT_CONTROL_TRIM ? 3 : 2;
+    if (argc > max_args) {
+        fprintf(stderr, "error: --control: %s: too many arguments\n", argv[0]);
+        return false;
+    }
+
+    uint32_t terminal_id = 0;
+    uint32_t arg = 0;
+
+    if (argc > 1 && !parse_control_number(argv[1], "terminal ID", true, &terminal_id))
+        return false;
+    if (argc > 2 && !parse_control_number(argv[2], "line count", false, &arg))
+        return false;
+
+    *ctrl = (struct client_control){
+        .version = CLIENT_CONTROL_VERSION,
+        .command = control_commands[i].command,
+        .terminal_id = terminal_id,
+        .arg = arg,
+    };
+
+    return true;
+}
+
+/* Sends a control request, and prints the server’s response on stdout */
+static bool
+control_request(int fd, const struct client_control *ctrl)
+{
+    const uint32_t total_len = CLIENT_CONTROL_REQUEST | sizeof(*ctrl);
+
+    if (sendall(fd, &total_len, sizeof(total_len)) < 0 ||
+        sendall(fd, ctrl, sizeof(*ctrl)) < 0)
+    {
+        LOG_ERRNO("failed to send control request to server");
+        return false;
+    }
+
+    uint32_t reply_len;
+    if (recvall(fd, &reply_len, sizeof(reply_len)) != sizeof(reply_len)) {
+        LOG_ERR("failed to read control response (is the server too old?)");
+        return false;
+    }
+
+    char *reply = xmalloc(reply_len);
+    bool ret = false;
+
+    if (recvall(fd, reply, reply_len) != (ssize_t)reply_len) {
+        LOG_ERR("failed to read control response");
+        goto out;
+    }
+
+    if (fwrite(reply, 1, reply_len, stdout) != reply_len) {
+        LOG_ERRNO("failed to write control response");
+        goto out;
+    }
+
+    ret = true;
+
+out:
+    free(reply);
+    return ret;
+}
+
 static const char *
 version_and_features(void)
 {
@@ -97,6 +249,8 @@ print_usage(const char *prog_name)
         "  -N,--no-wait                             detach the client process from the running terminal, exiting immediately\n"
         "  -o,--override=[section.]key=value        override configuration option\n"
         "  -E, --client-environment                 exec shell using footclient's environment, instead of the server's\n"
+        "      --stats                              print runtime statistics for all of the server's terminals, as JSON, and quit\n"
+        "      --control COMMAND [ID [LINES]]       send a control command (stats|list|trim|compact|drop-caches) to the server, and quit\n"
         "  -d,--log-level={info|warning|error|none} log level (warning)\n"
         "  -l,--log-colorize=[{never|always|auto}]  enable/disable colorization of log output on stderr\n"
         "  -v,--version                             show the version number and quit\n"
@@ -104,6 +258,7 @@ print_usage(const char *prog_name)
 
     printf("Usage: %s [OPTIONS...]\n", prog_name);
     printf("Usage: %s [OPTIONS...] command [ARGS...]\n", prog_name);
+    printf("Usage: %s [OPTIONS...] --control COMMAND [ID [LINES]]\n", prog_name);
     puts(options);
 }
 
@@ -172,6 +327,8 @@ main(int argc, char *const *argv)
         {"no-wait",            no_argument,       NULL, 'N'},
         {"override",           required_argument, NULL, 'o'},
         {"client-environment", no_argument,       NULL, 'E'},
+        {"stats",              no_argument,       NULL, OPT_STATS},
+        {"control",            no_argument,       NULL, OPT_CONTROL},
         {"log-level",          required_argument, NULL, 'd'},
         {"log-colorize",       optional_argument, NULL, 'l'},
         {"version",            no_argument,       NULL, 'v'},
@@ -185,6 +342,8 @@ main(int argc, char *const *argv)
     enum log_colorize log_colorize = LOG_COLORIZE_AUTO;
     bool hold = false;
     bool client_environment = false;
+    bool stats = false;
+    bool control = false;
 
     /* Used to format overrides */
     bool no_wait = false;
@@ -302,6 +461,14 @@ main(int argc, char *const *argv)
             client_environment = true;
             break;
 
+        case OPT_STATS:
+            stats = true;
+            break;
+
+        case OPT_CONTROL:
+            control = true;
+            break;
+
         case 'd': {
             int lvl = log_level_from_string(optarg);
             if (unlikely(lvl < 0)) {
@@ -354,6 +521,15 @@ main(int argc, char *const *argv)
 
     log_init(log_colorize, false, LOG_FACILITY_USER, log_level);
 
+    /* --stats is a shortcut for ‘--control stats’ */
+    struct client_control ctrl = {
+        .version = CLIENT_CONTROL_VERSION,
+        .command = CLIENT_CONTROL_STATS,
+    };
+
+    if (control && !parse_control_command(argc, argv, &ctrl))
+        goto err;
+
     fd = socket(AF_UNIX, SOCK_STREAM, 0);
     if (fd == -1) {
         LOG_ERRNO("failed to create socket");
@@ -396,6 +572,12 @@ main(int argc, char *const *argv)
         }
     }
 
+    if (stats || control) {
+        if (control_request(fd, &ctrl))
+            ret = EXIT_SUCCESS;
+        goto err;
+    }
+
     const char *cwd = custom_cwd;
     if (cwd == NULL) {
         errno = 0;
@@ -15,5 +15,7 @@ complete -c footclient -x -s o -l override
 complete -c footclient    -s E -l client-environment                                                        -d "child process inherits footclient's environment, instead of the server's"
 complete -c footclient -x -s d -l log-level          -a "info warning error none"                           -d "log-level (info)"
 complete -c footclient -x -s l -l log-colorize       -a "always never auto"                                 -d "enable or disable colorization of log output on stderr"
+complete -c footclient         -l stats                                                                     -d "print runtime statistics for all of the server's terminals, as JSON, and quit"
+complete -c footclient -x      -l control            -a "stats list trim compact drop-caches"               -d "send a control command to the server, and quit"
 complete -c footclient    -s v -l version                                                                   -d "show the version number and quit"
 complete -c footclient    -s h -l help                                                                      -d "show help message and quit"
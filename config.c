@@ -118,6 +118,7 @@ static const char *const binding_action_map[] = {
     [BIND_ACTION_PROMPT_PREV] = "prompt-prev",
     [BIND_ACTION_PROMPT_NEXT] = "prompt-next",
     [BIND_ACTION_UNICODE_INPUT] = "unicode-input",
+    [BIND_ACTION_SHOW_STATS] = "show-stats",
 
     /* Mouse-specific actions */
     [BIND_ACTION_SELECT_BEGIN] = "select-begin",
@@ -2472,6 +2473,19 @@ parse_section_tweak(struct context *ctx)
     else if (strcmp(key, "sixel") == 0)
         return value_to_bool(ctx, &conf->tweak.sixel);
 
+    else if (strcmp(key, "memory-pressure") == 0)
+        return value_to_bool(ctx, &conf->tweak.memory_pressure);
+
+    else if (strcmp(key, "memory-pressure-scrollback-lines") == 0)
+        return value_to_uint32(
+            ctx, 10, &conf->tweak.memory_pressure_scrollback_lines);
+
+    else if (strcmp(key, "flow-control-budget") == 0)
+        return value_to_uint32(ctx, 10, &conf->tweak.flow_control_budget_us);
+
+    else if (strcmp(key, "flow-control-fast-forward") == 0)
+        return value_to_bool(ctx, &conf->tweak.flow_control_fast_forward);
+
     else {
         LOG_CONTEXTUAL_ERR("not a valid option: %s", key);
         return false;
@@ -3045,6 +3059,10 @@ config_load(struct config *conf, const char *conf_path,
             .box_drawing_solid_shades = true,
             .font_monospace_warn = true,
             .sixel = true,
+            .memory_pressure = true,
+            .memory_pressure_scrollback_lines = 0,
+            .flow_control_budget_us = 0,
+            .flow_control_fast_forward = false,
         },
 
         .touch = {
@@ -346,6 +346,10 @@ struct config {
         bool box_drawing_solid_shades;
         bool font_monospace_warn;
         bool sixel;
+        bool memory_pressure;
+        uint32_t memory_pressure_scrollback_lines;
+        uint32_t flow_control_budget_us;
+        bool flow_control_fast_forward;
     } tweak;
 
     struct {
@@ -18,6 +18,7 @@
 #include "config.h"
 #include "debug.h"
 #include "grid.h"
+#include "render.h"
 #include "selection.h"
 #include "sixel.h"
 #include "util.h"
@@ -447,7 +448,8 @@ decset_decrst(struct terminal *term, unsigned param, bool enable)
                 min(term->normal.cursor.point.row, term->rows - 1),
                 min(term->normal.cursor.point.col, term->cols - 1));
 
-            tll_free(term->normal.scroll_damage);
+            render_alt_screen_entered(term);
+            term->normal.scroll_damage.count = 0;
             term_erase(term, 0, 0, term->rows - 1, term->cols - 1);
         }
 
@@ -469,9 +471,10 @@ decset_decrst(struct terminal *term, unsigned param, bool enable)
                 sixel_destroy(&it->item);
                 tll_remove(term->alt.sixel_images, it);
             }
+            sixel_index_invalidate(&term->alt);
 
-            tll_free(term->alt.scroll_damage);
-            term_damage_view(term);
+            term->alt.scroll_damage.count = 0;
+            render_alt_screen_exited(term);
         }
         term_update_ascii_printer(term);
         break;
@@ -997,6 +1000,8 @@ csi_dispatch(struct terminal *term, uint8_t final)
                     remaining * sizeof(term->grid->cur_row->cells[0]));
             for (size_t c = 0; c < remaining; c++)
                 term->grid->cur_row->cells[term->grid->cursor.point.col + count + c].attrs.clean = 0;
+            term->grid->cur_row->used = min(
+                term->grid->cur_row->used + count, term->cols);
             term->grid->cur_row->dirty = true;
 
             /* Erase (insert space characters) */
@@ -1,4 +1,6 @@
 #include "dcs.h"
+
+#include <stdlib.h>
 #include <string.h>
 
 #define LOG_MODULE "dcs"
@@ -58,9 +60,10 @@ err:
 
 UNITTEST
 {
-    /* Verify table is sorted */
+    /* Verify table is sorted, and that the index matches it */
     const char *p = terminfo_capabilities;
     size_t left = sizeof(terminfo_capabilities);
+    size_t idx = 0;
 
     const char *last_cap = NULL;
 
@@ -68,6 +71,11 @@ UNITTEST
         const char *cap = p;
         const char *val = cap + strlen(cap) + 1;
 
+        xassert(idx < ALEN(terminfo_index));
+        xassert(&terminfo_capabilities[terminfo_index[idx].name] == cap);
+        xassert(&terminfo_capabilities[terminfo_index[idx].value] == val);
+        idx++;
+
         size_t size = strlen(cap) + 1 + strlen(val) + 1;;
         xassert(size <= left);
         p += size;
@@ -78,47 +86,70 @@ UNITTEST
 
         last_cap = cap;
     }
+
+    xassert(idx == ALEN(terminfo_index));
+}
+
+static int
+terminfo_entry_compar(const void *_key, const void *_entry)
+{
+    const char *key = _key;
+    const struct foot_terminfo_entry *entry = _entry;
+
+    return strcmp(key, &terminfo_capabilities[entry->name]);
 }
 
 static bool
 lookup_capability(const char *name, const char **value)
 {
-    const char *p = terminfo_capabilities;
-    size_t left = sizeof(terminfo_capabilities);
+    const struct foot_terminfo_entry *entry = bsearch(
+        name, terminfo_index, ALEN(terminfo_index), sizeof(*entry),
+        &terminfo_entry_compar);
 
-    while (left > 0) {
-        const char *cap = p;
-        const char *val = cap + strlen(cap) + 1;
+    if (entry == NULL) {
+        *value = NULL;
+        return false;
+    }
 
-        size_t size = strlen(cap) + 1 + strlen(val) + 1;;
-        xassert(size <= left);
-        p += size;
-        left -= size;
+    *value = &terminfo_capabilities[entry->value];
+    return true;
+}
 
-        int r = strcmp(cap, name);
-        if (r == 0) {
-            *value = val;
-            return true;
-        } else if (r > 0)
-            break;
-    }
+UNITTEST
+{
+    const char *value;
+
+    xassert(lookup_capability("TN", &value));
+    xassert(strcmp(value, "foot") == 0);
 
-    *value = NULL;
-    return false;
+    xassert(lookup_capability("am", &value));
+    xassert(value[0] == '\0');
+
+    xassert(!lookup_capability("", &value));
+    xassert(!lookup_capability("does-not-exist", &value));
+    xassert(value == NULL);
+}
+
+static void NOINLINE
+append_reply(char **reply, size_t *len, const char *s, size_t n)
+{
+    *reply = xrealloc(*reply, *len + n);
+    memcpy(&(*reply)[*len], s, n);
+    *len += n;
 }
 
+/*
+ * Appends the reply for a single capability to ‘reply’. The caller
+ * is responsible for sending the (possibly batched) reply.
+ */
 static void
-xtgettcap_reply(struct terminal *term, const char *hex_cap_name, size_t len)
+xtgettcap_reply(char **reply, size_t *reply_len,
+                const char *hex_cap_name, size_t len)
 {
     char *name = hex_decode(hex_cap_name, len);
     if (name == NULL)
         goto err;
 
-#if 0
-    const struct foot_terminfo_entry *entry =
-        bsearch(name, terminfo_capabilities, ALEN(terminfo_capabilities),
-                sizeof(*entry), &terminfo_entry_compar);
-#endif
     const char *value;
     bool valid_capability = lookup_capability(name, &value);
     xassert(!valid_capability || value != NULL);
@@ -132,9 +163,9 @@ xtgettcap_reply(struct terminal *term, const char *hex_cap_name, size_t len)
 
     if (value[0] == '\0') {
         /* Boolean */
-        term_to_slave(term, "\033P1+r", 5);
-        term_to_slave(term, hex_cap_name, len);
-        term_to_slave(term, "\033\\", 2);
+        append_reply(reply, reply_len, "\033P1+r", 5);
+        append_reply(reply, reply_len, hex_cap_name, len);
+        append_reply(reply, reply_len, "\033\\", 2);
         goto out;
     }
 
@@ -143,35 +174,36 @@ xtgettcap_reply(struct terminal *term, const char *hex_cap_name, size_t len)
      *    \EP 1 + r cap=value \E\\
      * Where ‘cap’ and ‘value are hex encoded ascii strings
      */
-    char *reply = xmalloc(
+    const size_t max_len =
         5 +                           /* DCS 1 + r (\EP1+r) */
         len +                         /* capability name, hex encoded */
         1 +                           /* ‘=’ */
         strlen(value) * 2 +           /* capability value, hex encoded */
         2 +                           /* ST (\E\\) */
-        1);
+        1;
+
+    *reply = xrealloc(*reply, *reply_len + max_len);
 
-    int idx = sprintf(reply, "\033P1+r%.*s=", (int)len, hex_cap_name);
+    char *r = &(*reply)[*reply_len];
+    int idx = sprintf(r, "\033P1+r%.*s=", (int)len, hex_cap_name);
 
     for (const char *c = value; *c != '\0'; c++) {
         uint8_t nib1 = (uint8_t)*c >> 4;
         uint8_t nib2 = (uint8_t)*c & 0xf;
 
-        reply[idx] = nib1 >= 0xa ? 'A' + nib1 - 0xa : '0' + nib1; idx++;
-        reply[idx] = nib2 >= 0xa ? 'A' + nib2 - 0xa : '0' + nib2; idx++;
+        r[idx] = nib1 >= 0xa ? 'A' + nib1 - 0xa : '0' + nib1; idx++;
+        r[idx] = nib2 >= 0xa ? 'A' + nib2 - 0xa : '0' + nib2; idx++;
     }
 
-    reply[idx] = '\033'; idx++;
-    reply[idx] = '\\'; idx++;
-    term_to_slave(term, reply, idx);
-
-    free(reply);
+    r[idx] = '\033'; idx++;
+    r[idx] = '\\'; idx++;
+    *reply_len += idx;
     goto out;
 
 err:
-    term_to_slave(term, "\033P0+r", 5);
-    term_to_slave(term, hex_cap_name, len);
-    term_to_slave(term, "\033\\", 2);
+    append_reply(reply, reply_len, "\033P0+r", 5);
+    append_reply(reply, reply_len, hex_cap_name, len);
+    append_reply(reply, reply_len, "\033\\", 2);
 
 out:
     free(name);
@@ -195,6 +227,26 @@ xtgettcap_put(struct terminal *term, uint8_t c)
     vt->dcs.data[vt->dcs.idx++] = c;
 }
 
+static void
+xtgettcap_put_span(struct terminal *term, const uint8_t *data, size_t len)
+{
+    struct vt *vt = &term->vt;
+
+    if (vt->dcs.idx + len > vt->dcs.size) {
+        size_t new_size = vt->dcs.size * 2;
+        if (new_size == 0)
+            new_size = 128;
+        while (new_size < vt->dcs.idx + len)
+            new_size *= 2;
+
+        if (!ensure_size(term, new_size))
+            return;
+    }
+
+    memcpy(&vt->dcs.data[vt->dcs.idx], data, len);
+    vt->dcs.idx += len;
+}
+
 static void
 xtgettcap_unhook(struct terminal *term)
 {
@@ -203,6 +255,10 @@ xtgettcap_unhook(struct terminal *term)
     const char *const end = (const char *)&term->vt.dcs.data[left];
     const char *p = (const char *)term->vt.dcs.data;
 
+    /* Replies to all requested capabilities are sent in one go */
+    char *reply = NULL;
+    size_t reply_len = 0;
+
     while (true) {
         const char *sep = memchr(p, ';', left);
         size_t cap_len;
@@ -214,7 +270,7 @@ xtgettcap_unhook(struct terminal *term)
             cap_len = sep - p;
         }
 
-        xtgettcap_reply(term, p, cap_len);
+        xtgettcap_reply(&reply, &reply_len, p, cap_len);
 
         left -= cap_len + 1;
         p += cap_len + 1;
@@ -222,6 +278,9 @@ xtgettcap_unhook(struct terminal *term)
         if (sep == NULL)
             break;
     }
+
+    term_to_slave(term, reply, reply_len);
+    free(reply);
 }
 
 static void NOINLINE
@@ -414,6 +473,7 @@ dcs_hook(struct terminal *term, uint8_t final)
     xassert(term->vt.dcs.data == NULL);
     xassert(term->vt.dcs.size == 0);
     xassert(term->vt.dcs.put_handler == NULL);
+    xassert(term->vt.dcs.put_span_handler == NULL);
     xassert(term->vt.dcs.unhook_handler == NULL);
 
     switch (term->vt.private) {
@@ -463,6 +523,7 @@ dcs_hook(struct terminal *term, uint8_t final)
         switch (final) {
         case 'q':  /* XTGETTCAP */
             term->vt.dcs.put_handler = &xtgettcap_put;
+            term->vt.dcs.put_span_handler = &xtgettcap_put_span;
             term->vt.dcs.unhook_handler = &xtgettcap_unhook;
             break;
         }
@@ -479,6 +540,32 @@ dcs_put(struct terminal *term, uint8_t c)
         term->vt.dcs.put_handler(term, c);
 }
 
+/*
+ * Passes a run of printable characters to the current DCS handler.
+ *
+ * Handlers that buffer the data get the whole span in one go. All
+ * others are fed one byte at a time, but without a round-trip
+ * through the VT state machine for each byte.
+ */
+void
+dcs_put_span(struct terminal *term, const uint8_t *data, size_t len)
+{
+    if (term->vt.dcs.put_span_handler != NULL) {
+        term->vt.dcs.put_span_handler(term, data, len);
+        return;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        /* Re-load on each iteration; sixel switches handlers mid-stream */
+        void (*put)(struct terminal *term, uint8_t c) =
+            term->vt.dcs.put_handler;
+
+        if (put == NULL)
+            return;
+        put(term, data[i]);
+    }
+}
+
 void
 dcs_unhook(struct terminal *term)
 {
@@ -487,6 +574,7 @@ dcs_unhook(struct terminal *term)
 
     term->vt.dcs.unhook_handler = NULL;
     term->vt.dcs.put_handler = NULL;
+    term->vt.dcs.put_span_handler = NULL;
 
     free(term->vt.dcs.data);
     term->vt.dcs.data = NULL;
@@ -269,3 +269,19 @@ err:
     ctx->failed = true;
     return false;
 }
+
+bool
+extract_empty(const struct terminal *term, const struct row *row,
+              int col, int count, void *context)
+{
+    xassert(count > 0);
+
+    /* Equivalent to calling extract_one() on each (empty) cell */
+    if (!extract_one(term, row, &row->cells[col], col, context))
+        return false;
+
+    struct extraction_context *ctx = context;
+    ctx->empty_count += count - 1;
+    ctx->last_cell = &row->cells[col + count - 1];
+    return true;
+}
@@ -15,6 +15,11 @@ bool extract_one(
     const struct terminal *term, const struct row *row, const struct cell *cell,
     int col, void *context);
 
+/* Extract ‘count’ empty cells, starting at ‘col’ */
+bool extract_empty(
+    const struct terminal *term, const struct row *row, int col, int count,
+    void *context);
+
 bool extract_finish(
     struct extraction_context *context, char **text, size_t *len);
 bool extract_finish_wide(
@@ -98,8 +98,8 @@ verify_no_overlapping_uris(const struct row_data *extra)
                 (r1->start <= r2->end && r1->end >= r2->end))
             {
                 BUG("OSC-8 URI overlap: %s: %d-%d: %s: %d-%d",
-                    r1->uri, r1->start, r1->end,
-                    r2->uri, r2->start, r2->end);
+                    r1->uri->uri, r1->start, r1->end,
+                    r2->uri->uri, r2->start, r2->end);
             }
         }
     }
@@ -119,8 +119,8 @@ verify_uris_are_sorted(const struct row_data *extra)
             if (last->start >= r->start || last->end >= r->end) {
                 BUG("OSC-8 URI not sorted correctly: "
                     "%s: %d-%d came before %s: %d-%d",
-                    last->uri, last->start, last->end,
-                    r->uri, r->start, r->end);
+                    last->uri->uri, last->start, last->end,
+                    r->uri->uri, r->start, r->end);
             }
         }
 
@@ -129,6 +129,151 @@ verify_uris_are_sorted(const struct row_data *extra)
 #endif
 }
 
+static uint64_t
+uri_hash(uint64_t id, const char *uri)
+{
+    uint64_t hash = sdbm_hash(uri) ^ id;
+    return hash ^ (hash >> 32);
+}
+
+static void
+uri_table_grow(struct uri_table *table)
+{
+    const size_t new_size = table->size == 0 ? 64 : table->size * 2;
+    struct row_uri **new_buckets = xcalloc(new_size, sizeof(new_buckets[0]));
+
+    for (size_t i = 0; i < table->size; i++) {
+        struct row_uri *next;
+        for (struct row_uri *e = table->buckets[i]; e != NULL; e = next) {
+            next = e->next;
+
+            const size_t idx = e->hash & (new_size - 1);
+            e->next = new_buckets[idx];
+            new_buckets[idx] = e;
+        }
+    }
+
+    free(table->buckets);
+    table->buckets = new_buckets;
+    table->size = new_size;
+}
+
+/*
+ * Returns the (id, uri) entry from the URI table, creating it if it
+ * doesn’t already exist. The returned entry has been referenced;
+ * release it with grid_uri_unref().
+ */
+struct row_uri *
+grid_uri_intern(struct uri_table *table, uint64_t id, const char *uri)
+{
+    const uint64_t hash = uri_hash(id, uri);
+
+    if (table->size > 0) {
+        for (struct row_uri *e = table->buckets[hash & (table->size - 1)];
+             e != NULL;
+             e = e->next)
+        {
+            if (e->hash == hash && e->id == id && strcmp(e->uri, uri) == 0)
+                return grid_uri_ref(e);
+        }
+    }
+
+    /* Keep load factor below 0.75 */
+    if ((table->count + 1) * 4 > table->size * 3)
+        uri_table_grow(table);
+
+    struct row_uri *e = xmalloc(sizeof(*e));
+    const size_t idx = hash & (table->size - 1);
+
+    *e = (struct row_uri){
+        .id = id,
+        .uri = xstrdup(uri),
+        .hash = hash,
+        .ref_count = 1,
+        .table = table,
+        .next = table->buckets[idx],
+    };
+
+    table->buckets[idx] = e;
+    table->count++;
+    return e;
+}
+
+void
+grid_uri_unref(struct row_uri *uri)
+{
+    if (uri == NULL)
+        return;
+
+    xassert(uri->ref_count > 0);
+    if (--uri->ref_count > 0)
+        return;
+
+    struct uri_table *table = uri->table;
+    struct row_uri **prev = &table->buckets[uri->hash & (table->size - 1)];
+    while (*prev != uri)
+        prev = &(*prev)->next;
+
+    *prev = uri->next;
+    table->count--;
+
+    free(uri->uri);
+    free(uri);
+}
+
+void
+grid_uri_table_destroy(struct uri_table *table)
+{
+    /* All rows (and thus all references) must have been free:d */
+    xassert(table->count == 0);
+
+    free(table->buckets);
+    table->buckets = NULL;
+    table->size = 0;
+    table->count = 0;
+}
+
+UNITTEST
+{
+    struct uri_table table = {0};
+
+    struct row_uri *foo1 = grid_uri_intern(&table, 1, "http://foo");
+    struct row_uri *foo2 = grid_uri_intern(&table, 2, "http://foo");
+    struct row_uri *bar1 = grid_uri_intern(&table, 1, "http://bar");
+    xassert(foo1 != foo2);
+    xassert(foo1 != bar1);
+    xassert(table.count == 3);
+
+    struct row_uri *foo1_again = grid_uri_intern(&table, 1, "http://foo");
+    xassert(foo1_again == foo1);
+    xassert(foo1->ref_count == 2);
+    xassert(table.count == 3);
+
+    grid_uri_unref(foo1_again);
+    xassert(table.count == 3);
+    grid_uri_unref(foo1);
+    grid_uri_unref(foo2);
+    grid_uri_unref(bar1);
+    xassert(table.count == 0);
+
+    /* Force the table to be re-hashed */
+    struct row_uri *uris[200];
+    for (size_t i = 0; i < ALEN(uris); i++)
+        uris[i] = grid_uri_intern(&table, i, "http://foo");
+    xassert(table.count == ALEN(uris));
+    xassert(table.size > 64);
+
+    for (size_t i = 0; i < ALEN(uris); i++)
+        xassert(grid_uri_intern(&table, i, "http://foo") == uris[i]);
+    for (size_t i = 0; i < ALEN(uris); i++) {
+        grid_uri_unref(uris[i]);
+        grid_uri_unref(uris[i]);
+    }
+    xassert(table.count == 0);
+
+    grid_uri_table_destroy(&table);
+}
+
 static void
 uri_range_ensure_size(struct row_data *extra, uint32_t count_to_add)
 {
@@ -148,7 +293,7 @@ uri_range_ensure_size(struct row_data *extra, uint32_t count_to_add)
  */
 static void
 uri_range_insert(struct row_data *extra, size_t idx, int start, int end,
-                 uint64_t id, const char *uri)
+                 struct row_uri *uri)
 {
     uri_range_ensure_size(extra, 1);
 
@@ -163,29 +308,27 @@ uri_range_insert(struct row_data *extra, size_t idx, int start, int end,
     extra->uri_ranges.v[idx] = (struct row_uri_range){
         .start = start,
         .end = end,
-        .id = id,
-        .uri = xstrdup(uri),
+        .uri = grid_uri_ref(uri),
     };
 }
 
 static void
-uri_range_append_no_strdup(struct row_data *extra, int start, int end,
-                           uint64_t id, char *uri)
+uri_range_append_no_ref(struct row_data *extra, int start, int end,
+                        struct row_uri *uri)
 {
     uri_range_ensure_size(extra, 1);
     extra->uri_ranges.v[extra->uri_ranges.count++] = (struct row_uri_range){
         .start = start,
         .end = end,
-        .id = id,
         .uri = uri,
     };
 }
 
 static void
-uri_range_append(struct row_data *extra, int start, int end, uint64_t id,
-                 const char *uri)
+uri_range_append(struct row_data *extra, int start, int end,
+                 struct row_uri *uri)
 {
-    uri_range_append_no_strdup(extra, start, end, id, xstrdup(uri));
+    uri_range_append_no_ref(extra, start, end, grid_uri_ref(uri));
 }
 
 static void
@@ -213,11 +356,9 @@ grid_snapshot(const struct grid *grid)
     clone->saved_cursor = grid->saved_cursor;
     clone->kitty_kbd = grid->kitty_kbd;
     clone->rows = xcalloc(grid->num_rows, sizeof(clone->rows[0]));
-    memset(&clone->scroll_damage, 0, sizeof(clone->scroll_damage));
+    clone->scroll_damage = grid->scroll_damage;
     memset(&clone->sixel_images, 0, sizeof(clone->sixel_images));
-
-    tll_foreach(grid->scroll_damage, it)
-        tll_push_back(clone->scroll_damage, it->item);
+    memset(&clone->sixel_index, 0, sizeof(clone->sixel_index));
 
     for (int r = 0; r < grid->num_rows; r++) {
         const struct row *row = grid->rows[r];
@@ -229,6 +370,7 @@ grid_snapshot(const struct grid *grid)
         clone->rows[r] = clone_row;
 
         clone_row->cells = xmalloc(grid->num_cols * sizeof(clone_row->cells[0]));
+        clone_row->used = row->used;
         clone_row->linebreak = row->linebreak;
         clone_row->dirty = row->dirty;
         clone_row->prompt_marker = row->prompt_marker;
@@ -247,8 +389,7 @@ grid_snapshot(const struct grid *grid)
             for (size_t i = 0; i < extra->uri_ranges.count; i++) {
                 const struct row_uri_range *range = &extra->uri_ranges.v[i];
                 uri_range_append(
-                    clone_extra,
-                    range->start, range->end, range->id, range->uri);
+                    clone_extra, range->start, range->end, range->uri);
             }
         } else
             clone_row->extra = NULL;
@@ -303,6 +444,7 @@ grid_snapshot(const struct grid *grid)
             .cols = it->item.cols,
             .pos = it->item.pos,
             .opaque = it->item.opaque,
+            .id = it->item.id,
             .cell_width = it->item.cell_width,
             .cell_height = it->item.cell_height,
             .original = {
@@ -316,6 +458,7 @@ grid_snapshot(const struct grid *grid)
                 .pix = new_scaled_pix,
                 .width = scaled_width,
                 .height = scaled_height,
+                .preview = it->item.scaled.preview,
             },
         };
 
@@ -339,8 +482,13 @@ grid_free(struct grid *grid)
         tll_remove(grid->sixel_images, it);
     }
 
+    free(grid->sixel_index.rows);
+    grid->sixel_index.rows = NULL;
+    grid->sixel_index.num_rows = 0;
+    grid->sixel_index.valid = false;
+
     free(grid->rows);
-    tll_free(grid->scroll_damage);
+    grid->scroll_damage.count = 0;
 }
 
 void
@@ -368,16 +516,46 @@ grid_row_alloc(int cols, bool initialize)
     row->extra = NULL;
     row->prompt_marker = false;
 
+    row->cells = xmalloc(cols * sizeof(row->cells[0]));
+
     if (initialize) {
-        row->cells = xcalloc(cols, sizeof(row->cells[0]));
-        for (size_t c = 0; c < cols; c++)
-            row->cells[c].attrs.clean = 1;
-    } else
-        row->cells = xmalloc(cols * sizeof(row->cells[0]));
+        grid_cells_fill(
+            row->cells, (struct cell){.attrs = {.clean = 1}}, cols);
+        row->used = 0;
+    } else {
+        /* Content unknown; caller must lower it, if possible */
+        row->used = cols;
+    }
 
     return row;
 }
 
+bool
+grid_row_compact(struct row *row)
+{
+    struct row_data *extra = row->extra;
+
+    if (extra == NULL)
+        return false;
+
+    if (extra->uri_ranges.count == 0) {
+        free(extra->uri_ranges.v);
+        free(extra);
+        row->extra = NULL;
+        return true;
+    }
+
+    if (extra->uri_ranges.size > extra->uri_ranges.count) {
+        extra->uri_ranges.size = extra->uri_ranges.count;
+        extra->uri_ranges.v = xrealloc(
+            extra->uri_ranges.v,
+            extra->uri_ranges.size * sizeof(extra->uri_ranges.v[0]));
+        return true;
+    }
+
+    return false;
+}
+
 void
 grid_row_free(struct row *row)
 {
@@ -405,6 +583,7 @@ grid_resize_without_reflow(
     tll_foreach(grid->sixel_images, it)
         tll_push_back(untranslated_sixels, it->item);
     tll_free(grid->sixel_images);
+    sixel_index_invalidate(grid);
 
     int new_offset = 0;
 
@@ -423,6 +602,7 @@ grid_resize_without_reflow(
                old_row->cells,
                sizeof(struct cell) * min(old_cols, new_cols));
 
+        new_row->used = min(old_row->used, new_cols);
         new_row->dirty = old_row->dirty;
         new_row->linebreak = false;
         new_row->prompt_marker = old_row->prompt_marker;
@@ -473,7 +653,7 @@ grid_resize_without_reflow(
 
             const int start = range->start;
             const int end = min(range->end, new_cols - 1);
-            uri_range_append(new_extra, start, end, range->id, range->uri);
+            uri_range_append(new_extra, start, end, range->uri);
         }
     }
 
@@ -483,6 +663,7 @@ grid_resize_without_reflow(
         new_grid[(new_offset + r) & (new_rows - 1)] = new_row;
 
         memset(new_row->cells, 0, sizeof(struct cell) * new_cols);
+        new_row->used = 0;
         new_row->dirty = true;
     }
 
@@ -550,8 +731,7 @@ reflow_uri_range_start(struct row_uri_range *range, struct row *new_row,
                        int new_col_idx)
 {
     ensure_row_has_extra_data(new_row);
-    uri_range_append_no_strdup
-        (new_row->extra, new_col_idx, -1, range->id, range->uri);
+    uri_range_append_no_ref(new_row->extra, new_col_idx, -1, range->uri);
     range->uri = NULL;
 }
 
@@ -565,7 +745,8 @@ reflow_uri_range_end(struct row_uri_range *range, struct row *new_row,
     struct row_uri_range *new_range =
         &extra->uri_ranges.v[extra->uri_ranges.count - 1];
 
-    xassert(new_range->id == range->id);
+    /* Ownership was transferred by reflow_uri_range_start() */
+    xassert(range->uri == NULL);
     xassert(new_range->end < 0);
     new_range->end = new_col_idx;
 }
@@ -586,6 +767,7 @@ _line_wrap(struct grid *old_grid, struct row **new_grid, struct row *row,
     } else {
         /* Scrollback is full, need to re-use a row */
         grid_row_reset_extra(new_row);
+        new_row->used = col_count;
         new_row->linebreak = false;
         new_row->prompt_marker = false;
 
@@ -593,6 +775,7 @@ _line_wrap(struct grid *old_grid, struct row **new_grid, struct row *row,
             if (it->item.pos.row == *row_idx) {
                 sixel_destroy(&it->item);
                 tll_remove(old_grid->sixel_images, it);
+                sixel_index_invalidate(old_grid);
             }
         }
 
@@ -624,7 +807,7 @@ _line_wrap(struct grid *old_grid, struct row **new_grid, struct row *row,
 
             /* Open a new range on the new/current row */
             ensure_row_has_extra_data(new_row);
-            uri_range_append(new_row->extra, 0, -1, range->id, range->uri);
+            uri_range_append(new_row->extra, 0, -1, range->uri);
         }
     }
 
@@ -706,6 +889,7 @@ grid_resize_and_reflow(
     tll_foreach(grid->sixel_images, it)
         tll_push_back(untranslated_sixels, it->item);
     tll_free(grid->sixel_images);
+    sixel_index_invalidate(grid);
 
     /* Turn cursor coordinates into grid absolute coordinates */
     struct coord cursor = grid->cursor.point;
@@ -780,7 +964,7 @@ grid_resize_and_reflow(
 
         /* Find last non-empty cell */
         int col_count = 0;
-        for (int c = old_cols - 1; c >= 0; c--) {
+        for (int c = min(old_row->used, old_cols) - 1; c >= 0; c--) {
             const struct cell *cell = &old_row->cells[c];
             if (!(cell->wc == 0 || cell->wc == CELL_SPACER)) {
                 col_count = c + 1;
@@ -987,6 +1171,7 @@ grid_resize_and_reflow(
             /* Erase the remaining cells */
             memset(&new_row->cells[new_col_idx], 0,
                    (new_cols - new_col_idx) * sizeof(new_row->cells[0]));
+            new_row->used = new_col_idx;
             new_row->linebreak = true;
 
             if (r + 1 < old_rows)
@@ -1017,6 +1202,7 @@ grid_resize_and_reflow(
     /* Erase the remaining cells */
     memset(&new_row->cells[new_col_idx], 0,
            (new_cols - new_col_idx) * sizeof(new_row->cells[0]));
+    new_row->used = new_col_idx;
 
     for (struct coord **tp = next_tp; *tp != &terminator; tp++) {
         LOG_DBG("TP: row=%d, col=%d (old cols: %d, new cols: %d)",
@@ -1120,7 +1306,7 @@ grid_resize_and_reflow(
 }
 
 void
-grid_row_uri_range_put(struct row *row, int col, const char *uri, uint64_t id)
+grid_row_uri_range_put(struct row *row, int col, struct row_uri *uri)
 {
     ensure_row_has_extra_data(row);
 
@@ -1132,9 +1318,9 @@ grid_row_uri_range_put(struct row *row, int col, const char *uri, uint64_t id)
     for (ssize_t i = (ssize_t)extra->uri_ranges.count - 1; i >= 0; i--) {
         struct row_uri_range *r = &extra->uri_ranges.v[i];
 
-        const bool matching_id = r->id == id;
+        const bool matching_uri = r->uri == uri;
 
-        if (matching_id && r->end + 1 == col) {
+        if (matching_uri && r->end + 1 == col) {
             /* Extend existing URI’s tail */
             r->end++;
             goto out;
@@ -1152,7 +1338,7 @@ grid_row_uri_range_put(struct row *row, int col, const char *uri, uint64_t id)
             xassert(r->start <= col);
             xassert(r->end >= col);
 
-            if (matching_id)
+            if (matching_uri)
                 goto out;
 
             if (r->start == r->end) {
@@ -1171,7 +1357,7 @@ grid_row_uri_range_put(struct row *row, int col, const char *uri, uint64_t id)
                 xassert(r->start < col);
                 xassert(r->end > col);
 
-                uri_range_insert(extra, i + 1, col + 1, r->end, r->id, r->uri);
+                uri_range_insert(extra, i + 1, col + 1, r->end, r->uri);
 
                 /* The insertion may xrealloc() the vector, making our
                  * ‘old’ pointer invalid */
@@ -1193,18 +1379,17 @@ grid_row_uri_range_put(struct row *row, int col, const char *uri, uint64_t id)
         extra->uri_ranges.v[insert_idx] = (struct row_uri_range){
             .start = col,
             .end = col,
-            .id = id,
-            .uri = xstrdup(uri),
+            .uri = grid_uri_ref(uri),
         };
     } else
-        uri_range_insert(extra, insert_idx, col, col, id, uri);
+        uri_range_insert(extra, insert_idx, col, col, uri);
 
     if (run_merge_pass) {
         for (size_t i = 1; i < extra->uri_ranges.count; i++) {
             struct row_uri_range *r1 = &extra->uri_ranges.v[i - 1];
             struct row_uri_range *r2 = &extra->uri_ranges.v[i];
 
-            if (r1->id == r2->id && r1->end + 1 == r2->start) {
+            if (r1->uri == r2->uri && r1->end + 1 == r2->start) {
                 r1->end = r2->end;
                 uri_range_delete(extra, i);
                 i--;
@@ -1221,54 +1406,60 @@ UNITTEST
 {
     struct row_data row_data = {.uri_ranges = {0}};
     struct row row = {.extra = &row_data};
+    struct uri_table table = {0};
+
+    struct row_uri *foo = grid_uri_intern(&table, 123, "http://foo.bar");
+    struct row_uri *head = grid_uri_intern(&table, 456, "http://head");
+    struct row_uri *tail = grid_uri_intern(&table, 789, "http://tail");
+    struct row_uri *splice = grid_uri_intern(&table, 000, "http://splice");
 
 #define verify_range(idx, _start, _end, _id)                     \
     do {                                                         \
         xassert(idx < row_data.uri_ranges.count);                \
         xassert(row_data.uri_ranges.v[idx].start == _start);     \
         xassert(row_data.uri_ranges.v[idx].end == _end);         \
-        xassert(row_data.uri_ranges.v[idx].id == _id);           \
+        xassert(row_data.uri_ranges.v[idx].uri->id == _id);      \
     } while (0)
 
-    grid_row_uri_range_put(&row, 0, "http://foo.bar", 123);
-    grid_row_uri_range_put(&row, 1, "http://foo.bar", 123);
-    grid_row_uri_range_put(&row, 2, "http://foo.bar", 123);
-    grid_row_uri_range_put(&row, 3, "http://foo.bar", 123);
+    grid_row_uri_range_put(&row, 0, foo);
+    grid_row_uri_range_put(&row, 1, foo);
+    grid_row_uri_range_put(&row, 2, foo);
+    grid_row_uri_range_put(&row, 3, foo);
     xassert(row_data.uri_ranges.count == 1);
     verify_range(0, 0, 3, 123);
 
     /* No-op */
-    grid_row_uri_range_put(&row, 0, "http://foo.bar", 123);
+    grid_row_uri_range_put(&row, 0, foo);
     xassert(row_data.uri_ranges.count == 1);
     verify_range(0, 0, 3, 123);
 
     /* Replace head */
-    grid_row_uri_range_put(&row, 0, "http://head", 456);
+    grid_row_uri_range_put(&row, 0, head);
     xassert(row_data.uri_ranges.count == 2);
     verify_range(0, 0, 0, 456);
     verify_range(1, 1, 3, 123);
 
     /* Replace tail */
-    grid_row_uri_range_put(&row, 3, "http://tail", 789);
+    grid_row_uri_range_put(&row, 3, tail);
     xassert(row_data.uri_ranges.count == 3);
     verify_range(1, 1, 2, 123);
     verify_range(2, 3, 3, 789);
 
     /* Replace tail + extend head */
-    grid_row_uri_range_put(&row, 2, "http://tail", 789);
+    grid_row_uri_range_put(&row, 2, tail);
     xassert(row_data.uri_ranges.count == 3);
     verify_range(1, 1, 1, 123);
     verify_range(2, 2, 3, 789);
 
     /* Replace + extend tail */
-    grid_row_uri_range_put(&row, 1, "http://head", 456);
+    grid_row_uri_range_put(&row, 1, head);
     xassert(row_data.uri_ranges.count == 2);
     verify_range(0, 0, 1, 456);
     verify_range(1, 2, 3, 789);
 
     /* Replace + extend, then splice */
-    grid_row_uri_range_put(&row, 1, "http://tail", 789);
-    grid_row_uri_range_put(&row, 2, "http://splice", 000);
+    grid_row_uri_range_put(&row, 1, tail);
+    grid_row_uri_range_put(&row, 2, splice);
     xassert(row_data.uri_ranges.count == 4);
     verify_range(0, 0, 0, 456);
     verify_range(1, 1, 1, 789);
@@ -1279,6 +1470,13 @@ UNITTEST
         grid_row_uri_range_destroy(&row_data.uri_ranges.v[i]);
     free(row_data.uri_ranges.v);
 
+    grid_uri_unref(foo);
+    grid_uri_unref(head);
+    grid_uri_unref(tail);
+    grid_uri_unref(splice);
+    xassert(table.count == 0);
+    grid_uri_table_destroy(&table);
+
 #undef verify_range
 }
 
@@ -1307,8 +1505,7 @@ grid_row_uri_range_erase(struct row *row, int start, int end)
 
         else if (start > old->start && end < old->end) {
             /* Erase range erases a part in the middle of the URI */
-            uri_range_insert(
-                extra, i + 1, end + 1, old->end, old->id, old->uri);
+            uri_range_insert(extra, i + 1, end + 1, old->end, old->uri);
 
             /* The insertion may xrealloc() the vector, making our
              * ‘old’ pointer invalid */
@@ -1337,12 +1534,15 @@ UNITTEST
     struct row_data row_data = {.uri_ranges = {0}};
     struct row row = {.extra = &row_data};
 
+    struct uri_table table = {0};
+    struct row_uri *dummy = grid_uri_intern(&table, 0, "dummy");
+
     /* Try erasing a row without any URIs */
     grid_row_uri_range_erase(&row, 0, 200);
     xassert(row_data.uri_ranges.count == 0);
 
-    uri_range_append(&row_data, 1, 10, 0, "dummy");
-    uri_range_append(&row_data, 11, 20, 0, "dummy");
+    uri_range_append(&row_data, 1, 10, dummy);
+    uri_range_append(&row_data, 11, 20, dummy);
     xassert(row_data.uri_ranges.count == 2);
     xassert(row_data.uri_ranges.v[1].start == 11);
     xassert(row_data.uri_ranges.v[1].end == 20);
@@ -1357,8 +1557,8 @@ UNITTEST
 
     /* Two URIs, then erase second half of the first, first half of
        the second */
-    uri_range_append(&row_data, 1, 10, 0, "dummy");
-    uri_range_append(&row_data, 11, 20, 0, "dummy");
+    uri_range_append(&row_data, 1, 10, dummy);
+    uri_range_append(&row_data, 11, 20, dummy);
     grid_row_uri_range_erase(&row, 5, 15);
     xassert(row_data.uri_ranges.count == 2);
     xassert(row_data.uri_ranges.v[0].start == 1);
@@ -1373,7 +1573,7 @@ UNITTEST
     row_data.uri_ranges.count = 0;
 
     /* One URI, erase middle part of it */
-    uri_range_append(&row_data, 1, 10, 0, "dummy");
+    uri_range_append(&row_data, 1, 10, dummy);
     grid_row_uri_range_erase(&row, 5, 6);
     xassert(row_data.uri_ranges.count == 2);
     xassert(row_data.uri_ranges.v[0].start == 1);
@@ -1404,7 +1604,7 @@ UNITTEST
     free(row_data.uri_ranges.v);
     row_data.uri_ranges.v = NULL;
     row_data.uri_ranges.size = 0;
-    uri_range_append(&row_data, 1, 10, 0, "dummy");
+    uri_range_append(&row_data, 1, 10, dummy);
     xassert(row_data.uri_ranges.size == 1);
 
     grid_row_uri_range_erase(&row, 5, 7);
@@ -1413,4 +1613,78 @@ UNITTEST
     for (size_t i = 0; i < row_data.uri_ranges.count; i++)
         grid_row_uri_range_destroy(&row_data.uri_ranges.v[i]);
     free(row_data.uri_ranges.v);
+
+    grid_uri_unref(dummy);
+    xassert(table.count == 0);
+    grid_uri_table_destroy(&table);
+}
+
+UNITTEST
+{
+    struct uri_table table = {0};
+    struct row_uri *uri = grid_uri_intern(&table, 0, "uri");
+
+    struct row *row = grid_row_alloc(10, true);
+    xassert(!grid_row_compact(row));
+
+    grid_row_uri_range_put(row, 1, uri);
+    grid_row_uri_range_put(row, 5, uri);
+    xassert(row->extra->uri_ranges.count == 2);
+
+    /* Erasing shrinks ‘count’, but not the allocation */
+    grid_row_uri_range_erase(row, 5, 5);
+    xassert(row->extra->uri_ranges.count == 1);
+    xassert(row->extra->uri_ranges.size == 2);
+
+    xassert(grid_row_compact(row));
+    xassert(row->extra->uri_ranges.size == 1);
+    xassert(row->extra->uri_ranges.v[0].start == 1);
+    xassert(!grid_row_compact(row));
+
+    /* Empty ‘extra’ is freed completely */
+    grid_row_uri_range_erase(row, 0, 9);
+    xassert(row->extra->uri_ranges.count == 0);
+    xassert(grid_row_compact(row));
+    xassert(row->extra == NULL);
+
+    grid_row_free(row);
+    grid_uri_unref(uri);
+    xassert(table.count == 0);
+    grid_uri_table_destroy(&table);
+}
+
+UNITTEST
+{
+    const struct cell cell = {
+        .wc = U'x', .attrs = {.bg_src = COLOR_RGB, .bg = 0x123456}};
+
+    /* Cover both the 4-cell chunks, and the remainder */
+    for (size_t count = 0; count <= 9; count++) {
+        struct cell cells[11];
+        memset(cells, 0xff, sizeof(cells));
+
+        grid_cells_fill(&cells[1], cell, count);
+
+        xassert(cells[0].wc == 0xffffffff);
+        for (size_t i = 1; i <= count; i++)
+            xassert(memcmp(&cells[i], &cell, sizeof(cell)) == 0);
+        xassert(cells[count + 1].wc == 0xffffffff);
+    }
+}
+
+UNITTEST
+{
+    struct row *row = grid_row_alloc(10, true);
+    xassert(row->used == 0);
+
+    grid_row_mark_used(row, 5);
+    xassert(row->used == 5);
+    grid_row_mark_used(row, 3);
+    xassert(row->used == 5);
+    grid_row_free(row);
+
+    /* Uninitialized rows may have content everywhere */
+    row = grid_row_alloc(10, false);
+    xassert(row->used == 10);
+    grid_row_free(row);
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <stddef.h>
+#include <string.h>
+
 #include "debug.h"
 #include "terminal.h"
 
@@ -31,6 +33,32 @@ int grid_row_abs_to_sb_precalc_sb_start(
 int grid_row_sb_to_abs_precalc_sb_start(
     const struct grid *grid, int sb_start, int sb_rel_row);
 
+/*
+ * Set ‘count’ cells to ‘cell’. Cells are 12 bytes, so the cell is
+ * first expanded to a 4-cell (48 byte) pattern, which is then stored
+ * in fixed size chunks; the compiler turns each chunk into three
+ * 16-byte vector stores.
+ */
+static inline void
+grid_cells_fill(struct cell *cells, struct cell cell, size_t count)
+{
+    const struct cell pattern[4] = {cell, cell, cell, cell};
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        memcpy(&cells[i], pattern, sizeof(pattern));
+    for (; i < count; i++)
+        cells[i] = cell;
+}
+
+/* Must be called after writing cells in [0, end) */
+static inline void
+grid_row_mark_used(struct row *row, int end)
+{
+    if (end > row->used)
+        row->used = end;
+}
+
 static inline int
 grid_row_absolute(const struct grid *grid, int row_no)
 {
@@ -84,15 +112,29 @@ grid_row_in_view(struct grid *grid, int row_no)
     return row;
 }
 
-void grid_row_uri_range_put(
-    struct row *row, int col, const char *uri, uint64_t id);
+struct row_uri *grid_uri_intern(
+    struct uri_table *table, uint64_t id, const char *uri);
+void grid_uri_unref(struct row_uri *uri);
+void grid_uri_table_destroy(struct uri_table *table);
+
+static inline struct row_uri *
+grid_uri_ref(struct row_uri *uri)
+{
+    uri->ref_count++;
+    return uri;
+}
+
+void grid_row_uri_range_put(struct row *row, int col, struct row_uri *uri);
 void grid_row_uri_range_add(struct row *row, struct row_uri_range range);
 void grid_row_uri_range_erase(struct row *row, int start, int end);
 
+/* Releases unused ‘extra’ memory. Returns true if anything was freed */
+bool grid_row_compact(struct row *row);
+
 static inline void
 grid_row_uri_range_destroy(struct row_uri_range *range)
 {
-    free(range->uri);
+    grid_uri_unref(range->uri);
 }
 
 static inline void
@@ -421,6 +421,11 @@ execute_binding(struct seat *seat, struct terminal *term,
         unicode_mode_activate(seat);
         return true;
 
+    case BIND_ACTION_SHOW_STATS:
+        term->render.stats = !term->render.stats;
+        render_refresh(term);
+        return true;
+
     case BIND_ACTION_SELECT_BEGIN:
         selection_start(
             term, seat->mouse.col, seat->mouse.row, SELECTION_CHAR_WISE, false);
@@ -39,6 +39,7 @@ enum bind_action_normal {
     BIND_ACTION_PROMPT_PREV,
     BIND_ACTION_PROMPT_NEXT,
     BIND_ACTION_UNICODE_INPUT,
+    BIND_ACTION_SHOW_STATS,
 
     /* Mouse specific actions - i.e. they require a mouse coordinate */
     BIND_ACTION_SELECT_BEGIN,
@@ -49,7 +50,7 @@ enum bind_action_normal {
     BIND_ACTION_SELECT_WORD_WS,
     BIND_ACTION_SELECT_ROW,
 
-    BIND_ACTION_KEY_COUNT = BIND_ACTION_UNICODE_INPUT + 1,
+    BIND_ACTION_KEY_COUNT = BIND_ACTION_SHOW_STATS + 1,
     BIND_ACTION_COUNT = BIND_ACTION_SELECT_ROW + 1,
 };
 
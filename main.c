@@ -25,6 +25,7 @@
 #include "foot-features.h"
 #include "key-binding.h"
 #include "macros.h"
+#include "memory-pressure.h"
 #include "reaper.h"
 #include "render.h"
 #include "server.h"
@@ -583,6 +584,7 @@ main(int argc, char *const *argv)
     struct key_binding_manager *key_binding_manager = NULL;
     struct wayland *wayl = NULL;
     struct renderer *renderer = NULL;
+    struct memory_pressure *memory_pressure = NULL;
     struct terminal *term = NULL;
     struct server *server = NULL;
     struct shutdown_context shutdown_ctx = {.term = &term, .exit_code = foot_exit_failure};
@@ -646,6 +648,10 @@ main(int argc, char *const *argv)
     if ((renderer = render_init(fdm, wayl)) == NULL)
         goto out;
 
+    /* Optional; not a fatal error if unavailable */
+    if (conf.tweak.memory_pressure)
+        memory_pressure = memory_pressure_init(&conf, fdm, wayl);
+
     if (!as_server && (term = term_init(
                            &conf, fdm, reaper, wayl, "foot", cwd, token,
                            argc, argv, NULL,
@@ -695,6 +701,7 @@ out:
     server_destroy(server);
     term_destroy(term);
 
+    memory_pressure_destroy(memory_pressure);
     shm_fini();
     render_destroy(renderer);
     wayl_destroy(wayl);
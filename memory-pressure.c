@@ -0,0 +1,210 @@
+#include "memory-pressure.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/epoll.h>
+
+#define LOG_MODULE "memory-pressure"
+#define LOG_ENABLE_DBG 0
+#include "log.h"
+#include "render.h"
+#include "terminal.h"
+#include "util.h"
+#include "xmalloc.h"
+
+/*
+ * Notify us when tasks have been stalled on memory for at least
+ * 150ms, within a 2s window. Unprivileged users may only use
+ * windows that are a multiple of 2s.
+ */
+static const char trigger[] = "some 150000 2000000";
+
+/* Events closer than this to each other escalate the reclaim level */
+static const uint64_t escalation_window_ns = 10ull * 1000000000ull;
+
+enum reclaim_level {
+    RECLAIM_CACHES,      /* SHM buffers, sixel copies, custom glyphs */
+    RECLAIM_COMPACT,     /* + shrink over-allocated scrollback rows */
+    RECLAIM_SCROLLBACK,  /* + trim scrollback (if configured) */
+};
+
+struct memory_pressure {
+    const struct config *conf;
+    struct fdm *fdm;
+    struct wayland *wayl;
+    int fd;
+
+    enum reclaim_level level;
+    uint64_t last_event_ns;
+};
+
+static uint64_t
+now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+static void
+reclaim(struct memory_pressure *mp)
+{
+    const uint32_t keep = mp->conf->tweak.memory_pressure_scrollback_lines;
+
+    size_t released = 0;
+    size_t compacted = 0;
+    size_t rows = 0;
+
+    tll_foreach(mp->wayl->terms, it) {
+        struct terminal *term = it->item;
+
+        released += render_release_buffers(term);
+        released += term_drop_caches(term);
+
+        if (mp->level >= RECLAIM_COMPACT)
+            compacted += term_compact(term);
+
+        if (mp->level >= RECLAIM_SCROLLBACK && keep > 0)
+            rows += term_scrollback_trim(term, keep);
+    }
+
+    LOG_INFO("memory pressure (level %d): released %zu KiB, "
+             "compacted %zu rows, trimmed %zu scrollback rows, "
+             "in %zu terminal(s)",
+             mp->level, released / 1024, compacted, rows,
+             tll_length(mp->wayl->terms));
+}
+
+static bool
+fdm_memory_pressure(struct fdm *fdm, int fd, int events, void *data)
+{
+    struct memory_pressure *mp = data;
+
+    if (events & EPOLLERR) {
+        /* E.g. our cgroup was removed */
+        LOG_WARN("memory pressure trigger no longer available");
+        fdm_del(fdm, fd);
+        mp->fd = -1;
+        return true;
+    }
+
+    const uint64_t now = now_ns();
+
+    if (mp->last_event_ns != 0 &&
+        now - mp->last_event_ns < escalation_window_ns)
+    {
+        mp->level = min(mp->level + 1, RECLAIM_SCROLLBACK);
+    } else
+        mp->level = RECLAIM_CACHES;
+
+    mp->last_event_ns = now;
+    reclaim(mp);
+    return true;
+}
+
+static int
+open_trigger(const char *path)
+{
+    int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_DBG("%s: failed to open: %s", path, strerror(errno));
+        return -1;
+    }
+
+    if (write(fd, trigger, sizeof(trigger)) < 0) {
+        LOG_DBG("%s: failed to install trigger: %s", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    LOG_DBG("%s: installed trigger: %s", path, trigger);
+    return fd;
+}
+
+/* Trigger on our own cgroup (v2) */
+static int
+open_cgroup_trigger(void)
+{
+    FILE *f = fopen("/proc/self/cgroup", "re");
+    if (f == NULL)
+        return -1;
+
+    int fd = -1;
+    char *line = NULL;
+    size_t size = 0;
+
+    while (getline(&line, &size, f) >= 0) {
+        if (strncmp(line, "0::", 3) != 0)
+            continue;
+
+        char *cgroup = &line[3];
+        cgroup[strcspn(cgroup, "\n")] = '\0';
+
+        if (strcmp(cgroup, "/") == 0) {
+            /* Root cgroup has no pressure file; use the system wide one */
+            break;
+        }
+
+        char *path = xasprintf("/sys/fs/cgroup%s/memory.pressure", cgroup);
+        fd = open_trigger(path);
+        free(path);
+        break;
+    }
+
+    free(line);
+    fclose(f);
+    return fd;
+}
+
+struct memory_pressure *
+memory_pressure_init(const struct config *conf, struct fdm *fdm,
+                     struct wayland *wayl)
+{
+    int fd = open_cgroup_trigger();
+    if (fd < 0)
+        fd = open_trigger("/proc/pressure/memory");
+
+    if (fd < 0) {
+        LOG_INFO("memory pressure monitoring not available");
+        return NULL;
+    }
+
+    struct memory_pressure *mp = malloc(sizeof(*mp));
+    if (unlikely(mp == NULL)) {
+        LOG_ERRNO("malloc() failed");
+        close(fd);
+        return NULL;
+    }
+
+    *mp = (struct memory_pressure){
+        .conf = conf,
+        .fdm = fdm,
+        .wayl = wayl,
+        .fd = fd,
+        .level = RECLAIM_CACHES,
+    };
+
+    if (!fdm_add(fdm, fd, EPOLLPRI, &fdm_memory_pressure, mp)) {
+        close(fd);
+        free(mp);
+        return NULL;
+    }
+
+    return mp;
+}
+
+void
+memory_pressure_destroy(struct memory_pressure *mp)
+{
+    if (mp == NULL)
+        return;
+
+    if (mp->fd >= 0)
+        fdm_del(mp->fdm, mp->fd);
+    free(mp);
+}
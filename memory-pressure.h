@@ -0,0 +1,15 @@
+#pragma once
+
+#include "config.h"
+#include "fdm.h"
+#include "wayland.h"
+
+struct memory_pressure;
+
+/*
+ * Subscribes to memory pressure notifications (Linux PSI). Returns
+ * NULL if not supported on this system.
+ */
+struct memory_pressure *memory_pressure_init(
+    const struct config *conf, struct fdm *fdm, struct wayland *wayl);
+void memory_pressure_destroy(struct memory_pressure *mp);
@@ -26,7 +26,7 @@
 
 static void
 osc_to_clipboard(struct terminal *term, const char *target,
-                 const char *base64_data)
+                 struct selection_text *text)
 {
     bool to_clipboard = false;
     bool to_primary = false;
@@ -65,13 +65,7 @@ osc_to_clipboard(struct terminal *term, const char *target,
         return;
     }
 
-    char *decoded = base64_decode(base64_data);
-    if (decoded == NULL) {
-        if (errno == EINVAL)
-            LOG_WARN("OSC: invalid clipboard data: %s", base64_data);
-        else
-            LOG_ERRNO("base64_decode() failed");
-
+    if (text == NULL) {
         if (to_clipboard)
             selection_clipboard_unset(seat);
         if (to_primary)
@@ -79,21 +73,173 @@ osc_to_clipboard(struct terminal *term, const char *target,
         return;
     }
 
-    LOG_DBG("decoded: %s", decoded);
+    LOG_DBG("decoded: %.*s", (int)text->len, text->data);
+
+    /* Clipboard and primary share the same, decoded, data */
+    if (to_clipboard)
+        shared_text_to_clipboard(seat, term, text, seat->kbd.serial);
+    if (to_primary)
+        shared_text_to_primary(seat, term, text, seat->kbd.serial);
+}
+
+/*
+ * Grows ‘*data’ to at least ‘required_size’ bytes, in powers of
+ * two. On failure, the buffer is left untouched.
+ */
+static bool
+buffer_ensure_size(void **data, size_t *size, size_t required_size,
+                   const char *name)
+{
+    if (likely(required_size <= *size))
+        return true;
+
+    const size_t pow2_max = ~(SIZE_MAX >> 1);
+    if (unlikely(required_size > pow2_max)) {
+        LOG_ERR("required %s buffer size (%zu) exceeds limit (%zu)",
+            name, required_size, pow2_max);
+        return false;
+    }
+
+    size_t new_size = max(*size, 4096);
+    while (new_size < required_size) {
+        new_size <<= 1;
+    }
+
+    void *new_data = realloc(*data, new_size);
+    if (new_data == NULL) {
+        LOG_ERRNO("failed to increase size of %s buffer", name);
+        return false;
+    }
+
+    LOG_DBG("resized %s buffer: %zu", name, new_size);
+    *data = new_data;
+    *size = new_size;
+    return true;
+}
+
+static bool
+clip_ensure_size(struct terminal *term, size_t required_size)
+{
+    void *data = term->vt.osc.clip.data;
+    if (!buffer_ensure_size(
+            &data, &term->vt.osc.clip.size, required_size, "OSC52"))
+        return false;
+
+    term->vt.osc.clip.data = data;
+    return true;
+}
+
+void
+osc_clipboard_start(struct terminal *term)
+{
+    /*
+     * Called when a ‘;’ has been added to the OSC buffer. Look for
+     * “52;<targets>;”, and if found, start decoding the payload as
+     * it is being received, instead of buffering it.
+     */
+    const uint8_t *data = term->vt.osc.data;
+    const size_t idx = term->vt.osc.idx;
+
+    if (idx < 4 || data[0] != '5' || data[1] != '2' || data[2] != ';')
+        return;
+
+    if (memchr(&data[3], ';', idx - 4) != NULL)
+        return;
+
+    osc_clipboard_reset(term);
+    term->vt.osc.clip.active = true;
+}
+
+void
+osc_clipboard_reset(struct terminal *term)
+{
+    free(term->vt.osc.clip.data);
+    term->vt.osc.clip.data = NULL;
+    term->vt.osc.clip.size = 0;
+    term->vt.osc.clip.idx = 0;
+    term->vt.osc.clip.decoder = (struct base64_decoder){0};
+    term->vt.osc.clip.active = false;
+}
+
+size_t
+osc_clipboard_put(struct terminal *term, const uint8_t *data, size_t len)
+{
+    xassert(term->vt.osc.clip.active);
+    xassert(len > 0);
 
-    if (to_clipboard) {
-        char *copy = xstrdup(decoded);
-        if (!text_to_clipboard(seat, term, copy, seat->kbd.serial))
-            free(copy);
+    if (term->vt.osc.clip.data == NULL && data[0] == '?') {
+        /* Clipboard query - let the regular OSC path handle it */
+        term->vt.osc.clip.active = false;
+        return 0;
     }
 
-    if (to_primary) {
-        char *copy = xstrdup(decoded);
-        if (!text_to_primary(seat, term, copy, seat->kbd.serial))
-            free(copy);
+    /*
+     * The payload is (most likely) terminated by ST (ESC \) or BEL;
+     * bound the chunk we decode by the first one, if any.
+     *
+     * Other control characters (e.g. CAN/SUB) aren’t part of the
+     * base64 alphabet, and will stop the decoder. These are then
+     * handled by the VT parser, as usual.
+     */
+    size_t span = len;
+    const uint8_t *esc = memchr(data, '\033', span);
+    if (esc != NULL)
+        span = esc - data;
+    const uint8_t *bel = memchr(data, '\a', span);
+    if (bel != NULL)
+        span = bel - data;
+
+    if (span == 0)
+        return 0;
+
+    struct base64_decoder *decoder = &term->vt.osc.clip.decoder;
+    const size_t idx = term->vt.osc.clip.idx;
+
+    if (!clip_ensure_size(term, idx + BASE64_DECODED_MAX(span) + 1)) {
+        /* Discard the payload */
+        decoder->invalid = true;
+        return span;
     }
 
-    free(decoded);
+    size_t decoded;
+    size_t consumed = base64_decode_stream(
+        decoder, (const char *)data, span,
+        (uint8_t *)&term->vt.osc.clip.data[idx], &decoded);
+
+    term->vt.osc.clip.idx += decoded;
+
+    if (consumed < span && data[consumed] >= 0x20) {
+        /* Not a control character, and not part of the base64 alphabet */
+        decoder->invalid = true;
+        consumed++;
+    }
+
+    return consumed;
+}
+
+static struct selection_text *
+osc_clipboard_finish(struct terminal *term)
+{
+    xassert(term->vt.osc.clip.active);
+
+    struct selection_text *text = NULL;
+
+    if (base64_decode_stream_finish(&term->vt.osc.clip.decoder) &&
+        clip_ensure_size(term, term->vt.osc.clip.idx + 1))
+    {
+        char *data = term->vt.osc.clip.data;
+        const size_t len = term->vt.osc.clip.idx;
+
+        data[len] = '\0';
+        text = selection_text_new(data, len);
+
+        /* Now owned by ‘text’ */
+        term->vt.osc.clip.data = NULL;
+    } else
+        LOG_WARN("OSC: invalid clipboard data");
+
+    osc_clipboard_reset(term);
+    return text;
 }
 
 struct clip_context {
@@ -252,10 +398,23 @@ osc_selection(struct terminal *term, char *string)
 
     LOG_DBG("clipboard: target = %s data = %s", string, p);
 
-    if (p[0] == '?' && p[1] == '\0')
+    if (term->vt.osc.clip.active) {
+        /* Payload has already been decoded, by osc_clipboard_put() */
+        xassert(p[0] == '\0');
+
+        struct selection_text *text = osc_clipboard_finish(term);
+        osc_to_clipboard(term, string, text);
+        selection_text_unref(text);
+    }
+
+    else if (p[0] == '?' && p[1] == '\0')
         osc_from_clipboard(term, string);
-    else
-        osc_to_clipboard(term, string, p);
+
+    else {
+        /* Payload starting with a ‘?’, that isn’t a query */
+        LOG_WARN("OSC: invalid clipboard data: %s", p);
+        osc_to_clipboard(term, string, NULL);
+    }
 }
 
 static void
@@ -945,29 +1104,11 @@ osc_dispatch(struct terminal *term)
 bool
 osc_ensure_size(struct terminal *term, size_t required_size)
 {
-    if (likely(required_size <= term->vt.osc.size))
-        return true;
-
-    const size_t pow2_max = ~(SIZE_MAX >> 1);
-    if (unlikely(required_size > pow2_max)) {
-        LOG_ERR("required OSC buffer size (%zu) exceeds limit (%zu)",
-            required_size, pow2_max);
-        return false;
-    }
-
-    size_t new_size = max(term->vt.osc.size, 4096);
-    while (new_size < required_size) {
-        new_size <<= 1;
-    }
-
-    uint8_t *new_data = realloc(term->vt.osc.data, new_size);
-    if (new_data == NULL) {
-        LOG_ERRNO("failed to increase size of OSC buffer");
+    void *data = term->vt.osc.data;
+    if (!buffer_ensure_size(
+            &data, &term->vt.osc.size, required_size, "OSC"))
         return false;
-    }
 
-    LOG_DBG("resized OSC buffer: %zu", new_size);
-    term->vt.osc.data = new_data;
-    term->vt.osc.size = new_size;
+    term->vt.osc.data = data;
     return true;
 }
@@ -5,3 +5,9 @@
 
 bool osc_ensure_size(struct terminal *term, size_t required_size);
 void osc_dispatch(struct terminal *term);
+
+/* OSC 52 payload streaming */
+void osc_clipboard_start(struct terminal *term);
+void osc_clipboard_reset(struct terminal *term);
+size_t osc_clipboard_put(
+    struct terminal *term, const uint8_t *data, size_t len);
@@ -67,6 +67,7 @@ render_resize_force(struct terminal *term, int width, int height)
 
 void render_refresh(struct terminal *term) {}
 void render_refresh_csd(struct terminal *term) {}
+void render_refresh_cursor(struct terminal *term) {}
 void render_refresh_title(struct terminal *term) {}
 
 bool
@@ -96,6 +97,7 @@ wayl_win_init(struct terminal *term, const char *token)
 void wayl_win_destroy(struct wl_window *win) {}
 void wayl_win_alpha_changed(struct wl_window *win) {}
 bool wayl_win_set_urgent(struct wl_window *win) { return true; }
+void wayl_flush_unblock(struct wayland *wayl) {}
 
 bool
 spawn(struct reaper *reaper, const char *cwd, char *const argv[],
@@ -121,6 +123,11 @@ render_worker_thread(void *_ctx)
     return 0;
 }
 
+void render_sixel_scaler_destroy(struct terminal *term) {}
+void render_alt_screen_entered(struct terminal *term) {}
+void render_alt_screen_exited(struct terminal *term) {}
+void render_normal_screen_destroy(struct terminal *term) {}
+
 struct extraction_context *
 extract_begin(enum selection_kind kind, bool strip_trailing_empty)
 {
@@ -135,6 +142,14 @@ extract_one(
     return true;
 }
 
+bool
+extract_empty(
+    const struct terminal *term, const struct row *row, int col, int count,
+    void *context)
+{
+    return true;
+}
+
 bool
 extract_finish(struct extraction_context *context, char **text, size_t *len)
 {
@@ -169,6 +184,7 @@ shm_chain_new(struct wl_shm *shm, bool scrollable, size_t pix_instances)
 
 
 void search_selection_cancelled(struct terminal *term) {}
+void search_matches_cache_destroy(struct terminal *term) {}
 
 void get_current_modifiers(const struct seat *seat,
                            xkb_mod_mask_t *effective,
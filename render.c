@@ -1,6 +1,7 @@
 #include "render.h"
 
 #include <string.h>
+#include <errno.h>
 #include <wctype.h>
 #include <unistd.h>
 #include <signal.h>
@@ -9,6 +10,7 @@
 #include <sys/time.h>
 #include <sys/timerfd.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <pthread.h>
 
 #include "macros.h"
@@ -40,6 +42,7 @@
 #include "selection.h"
 #include "shm.h"
 #include "sixel.h"
+#include "stats.h"
 #include "url-mode.h"
 #include "util.h"
 #include "xmalloc.h"
@@ -225,7 +228,10 @@ static struct fcft_font *
 attrs_to_font(const struct terminal *term, const struct attributes *attrs)
 {
     int idx = attrs->italic << 1 | attrs->bold;
-    return term->fonts[idx];
+
+    /* Bold/italic fonts are loaded in the background */
+    struct fcft_font *font = term->fonts[idx];
+    return likely(font != NULL) ? font : term->fonts[0];
 }
 
 static inline pixman_color_t
@@ -462,43 +468,37 @@ draw_cursor(const struct terminal *term, const struct cell *cell,
     }
 }
 
-static int
-render_cell(struct terminal *term, pixman_image_t *pix,
-            struct row *row, int col, int row_no, bool has_cursor)
+/*
+ * Renders the cell at x,y in ‘pix’. With ‘cursor_only’, only the
+ * parts not already rendered by the grid (i.e. the cursor) are
+ * rendered; used by the cursor sub-surface
+ */
+/* Foreground and background colors, before dim/bold/blink adjustments */
+static void
+cell_colors(const struct terminal *term, const struct attributes *attrs,
+            uint32_t *fg, uint32_t *bg, uint16_t *alpha)
 {
-    struct cell *cell = &row->cells[col];
-    if (cell->attrs.clean)
-        return 0;
-
-    cell->attrs.clean = 1;
-    cell->attrs.confined = true;
-
-    int width = term->cell_width;
-    int height = term->cell_height;
-    const int x = term->margins.left + col * width;
-    const int y = term->margins.top + row_no * height;
-
-    bool is_selected = cell->attrs.selected;
+    const bool is_selected = attrs->selected;
 
     uint32_t _fg = 0;
     uint32_t _bg = 0;
 
-    uint16_t alpha = 0xffff;
+    *alpha = 0xffff;
 
     if (is_selected && term->colors.use_custom_selection) {
         _fg = term->colors.selection_fg;
         _bg = term->colors.selection_bg;
     } else {
         /* Use cell specific color, if set, otherwise the default colors (possible reversed) */
-        switch (cell->attrs.fg_src) {
+        switch (attrs->fg_src) {
         case COLOR_RGB:
-            _fg = cell->attrs.fg;
+            _fg = attrs->fg;
             break;
 
         case COLOR_BASE16:
         case COLOR_BASE256:
-            xassert(cell->attrs.fg < ALEN(term->colors.table));
-            _fg = term->colors.table[cell->attrs.fg];
+            xassert(attrs->fg < ALEN(term->colors.table));
+            _fg = term->colors.table[attrs->fg];
             break;
 
         case COLOR_DEFAULT:
@@ -506,15 +506,15 @@ render_cell(struct terminal *term, pixman_image_t *pix,
             break;
         }
 
-        switch (cell->attrs.bg_src) {
+        switch (attrs->bg_src) {
         case COLOR_RGB:
-            _bg = cell->attrs.bg;
+            _bg = attrs->bg;
             break;
 
         case COLOR_BASE16:
         case COLOR_BASE256:
-            xassert(cell->attrs.bg < ALEN(term->colors.table));
-            _bg = term->colors.table[cell->attrs.bg];
+            xassert(attrs->bg < ALEN(term->colors.table));
+            _bg = term->colors.table[attrs->bg];
             break;
 
         case COLOR_DEFAULT:
@@ -522,20 +522,40 @@ render_cell(struct terminal *term, pixman_image_t *pix,
             break;
         }
 
-        if (cell->attrs.reverse ^ is_selected) {
+        if (attrs->reverse ^ is_selected) {
             uint32_t swap = _fg;
             _fg = _bg;
             _bg = swap;
-        } else if (cell->attrs.bg_src == COLOR_DEFAULT)
-            alpha = term->colors.alpha;
+        } else if (attrs->bg_src == COLOR_DEFAULT)
+            *alpha = term->colors.alpha;
     }
 
     if (unlikely(is_selected && _fg == _bg)) {
         /* Invert bg when selected/highlighted text has same fg/bg */
         _bg = ~_bg;
-        alpha = 0xffff;
+        *alpha = 0xffff;
     }
 
+    *fg = _fg;
+    *bg = _bg;
+}
+
+static int
+render_cell_at(struct terminal *term, pixman_image_t *pix,
+               struct row *row, int col, int x, int y,
+               bool has_cursor, bool cursor_only)
+{
+    struct cell *cell = &row->cells[col];
+
+    int width = term->cell_width;
+    int height = term->cell_height;
+
+    const bool is_selected = cell->attrs.selected;
+
+    uint32_t _fg, _bg;
+    uint16_t alpha;
+    cell_colors(term, &cell->attrs, &_fg, &_bg, &alpha);
+
     if (cell->attrs.dim)
         _fg = color_dim(term, _fg);
     if (term->conf->bold_in_bright.enabled && cell->attrs.bold)
@@ -693,6 +713,13 @@ render_cell(struct terminal *term, pixman_image_t *pix,
     pixman_image_set_clip_region32(pix, &clip);
     pixman_region32_fini(&clip);
 
+    if (unlikely(cursor_only) &&
+        (term->cursor_style != CURSOR_BLOCK || !term->kbd_focus))
+    {
+        /* Cell is already rendered by the grid, beneath us */
+        goto draw_cursor;
+    }
+
     /* Background */
     pixman_image_fill_rectangles(
         PIXMAN_OP_SRC, pix, &bg, 1,
@@ -816,11 +843,104 @@ draw_cursor:
     return cell_cols;
 }
 
+static int
+render_cell(struct terminal *term, pixman_image_t *pix,
+            struct row *row, int col, int row_no, bool has_cursor)
+{
+    struct cell *cell = &row->cells[col];
+    if (cell->attrs.clean)
+        return 0;
+
+    cell->attrs.clean = 1;
+    cell->attrs.confined = true;
+
+    return render_cell_at(
+        term, pix, row, col,
+        term->margins.left + col * term->cell_width,
+        term->margins.top + row_no * term->cell_height,
+        has_cursor, false);
+}
+
+static bool
+empty_cells_look_the_same(struct attributes a, struct attributes b)
+{
+    /* Ignore render state */
+    a.clean = b.clean = false;
+    a.confined = b.confined = false;
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+/*
+ * Renders a run of empty cells, ending at ‘col’, and starting at
+ * ‘first_col’ at the earliest, with a single background fill. The
+ * run is cut short by clean cells, the cursor, and cells with
+ * different attributes.
+ *
+ * Returns the number of cells consumed.
+ */
+static int
+render_empty_cells(struct terminal *term, pixman_image_t *pix,
+                   struct row *row, int col, int first_col, int row_no,
+                   int cursor_col)
+{
+    struct cell *cell = &row->cells[col];
+    xassert(cell->wc == 0);
+
+    if (cell->attrs.clean)
+        return 1;
+
+    if (col == cursor_col || cell->attrs.blink) {
+        render_cell(term, pix, row, col, row_no, col == cursor_col);
+        return 1;
+    }
+
+    int start = col;
+    while (start > first_col) {
+        const struct cell *prev = &row->cells[start - 1];
+
+        if (start - 1 == cursor_col ||
+            prev->attrs.clean ||
+            !empty_cells_look_the_same(prev->attrs, cell->attrs))
+        {
+            break;
+        }
+
+        start--;
+    }
+
+    uint32_t _fg, _bg;
+    uint16_t alpha;
+    cell_colors(term, &cell->attrs, &_fg, &_bg, &alpha);
+
+    pixman_color_t bg = color_hex_to_pixman_with_alpha(_bg, alpha);
+    pixman_image_fill_rectangles(
+        PIXMAN_OP_SRC, pix, &bg, 1,
+        &(pixman_rectangle16_t){
+            term->margins.left + start * term->cell_width,
+            term->margins.top + row_no * term->cell_height,
+            (col - start + 1) * term->cell_width,
+            term->cell_height});
+
+    for (int c = start; c <= col; c++) {
+        row->cells[c].attrs.clean = 1;
+        row->cells[c].attrs.confined = true;
+    }
+
+    return col - start + 1;
+}
+
 static void
 render_row(struct terminal *term, pixman_image_t *pix, struct row *row,
            int row_no, int cursor_col)
 {
-    for (int col = term->cols - 1; col >= 0; col--)
+    const int used = min(row->used, term->cols);
+    int col = term->cols - 1;
+
+    /* Everything after the used width is empty */
+    while (col >= used)
+        col -= render_empty_cells(term, pix, row, col, used, row_no, cursor_col);
+
+    for (; col >= 0; col--)
         render_cell(term, pix, row, col, row_no, cursor_col == col);
 }
 
@@ -850,6 +970,75 @@ render_urgency(struct terminal *term, struct buffer *buf)
         });
 }
 
+/*
+ * Above this number of rectangles, a surface's damage is submitted
+ * as its bounding box instead.
+ */
+static const int max_damage_rects = 32;
+
+/*
+ * Surface damage is accumulated in a pixman region, and submitted
+ * once, just before the surface is committed. This coalesces
+ * overlapping and adjacent rectangles (e.g. the margins, and
+ * consecutive dirty rows), instead of sending each one to the
+ * compositor.
+ */
+static void
+damage_add(struct terminal *term, pixman_region32_t *damage,
+           int x, int y, int width, int height)
+{
+    if (width <= 0 || height <= 0)
+        return;
+
+    pixman_region32_union_rect(damage, damage, x, y, width, height);
+    term->stats.damage.rects++;
+}
+
+static void
+damage_main_surface(struct terminal *term, int x, int y, int width, int height)
+{
+    damage_add(term, &term->render.damage, x, y, width, height);
+}
+
+static void
+damage_submit(struct terminal *term, struct wl_surface *surf,
+              pixman_region32_t *damage)
+{
+    int n_rects = -1;
+    const pixman_box32_t *boxes = pixman_region32_rectangles(damage, &n_rects);
+
+    if (n_rects > 1) {
+        /*
+         * Use the bounding box if there are too many rectangles, or
+         * if it covers (almost) nothing but the damage itself
+         */
+        const pixman_box32_t *extents = pixman_region32_extents(damage);
+        const uint64_t extents_area =
+            (uint64_t)(extents->x2 - extents->x1) * (extents->y2 - extents->y1);
+
+        uint64_t area = 0;
+        for (int i = 0; i < n_rects; i++) {
+            area += (uint64_t)(boxes[i].x2 - boxes[i].x1) *
+                    (boxes[i].y2 - boxes[i].y1);
+        }
+
+        if (n_rects > max_damage_rects || extents_area - area <= area / 8) {
+            boxes = extents;
+            n_rects = 1;
+        }
+    }
+
+    for (int i = 0; i < n_rects; i++) {
+        wl_surface_damage_buffer(
+            surf,
+            boxes[i].x1, boxes[i].y1,
+            boxes[i].x2 - boxes[i].x1, boxes[i].y2 - boxes[i].y1);
+    }
+
+    term->stats.damage.sent += n_rects;
+    pixman_region32_clear(damage);
+}
+
 static void
 render_margin(struct terminal *term, struct buffer *buf,
               int start_line, int end_line, bool apply_damage)
@@ -897,22 +1086,21 @@ render_margin(struct terminal *term, struct buffer *buf,
 
     if (apply_damage) {
         /* Top */
-        wl_surface_damage_buffer(
-            term->window->surface.surf, 0, 0, term->width, term->margins.top);
+        damage_main_surface(term, 0, 0, term->width, term->margins.top);
 
         /* Bottom */
-        wl_surface_damage_buffer(
-            term->window->surface.surf, 0, bmargin, term->width, term->margins.bottom);
+        damage_main_surface(
+            term, 0, bmargin, term->width, term->margins.bottom);
 
         /* Left */
-        wl_surface_damage_buffer(
-            term->window->surface.surf,
+        damage_main_surface(
+            term,
             0, term->margins.top + start_line * term->cell_height,
             term->margins.left, line_count * term->cell_height);
 
         /* Right */
-        wl_surface_damage_buffer(
-            term->window->surface.surf,
+        damage_main_surface(
+            term,
             rmargin, term->margins.top + start_line * term->cell_height,
             term->margins.right, line_count * term->cell_height);
     }
@@ -999,12 +1187,14 @@ grid_render_scroll(struct terminal *term, struct buffer *buf,
         /* Restore margins */
         render_margin(
             term, buf, dmg->region.end - dmg->lines, term->rows, false);
+        term->stats.scroll.shm++;
     } else {
         /* Fallback for when we either cannot do SHM scrolling, or it failed */
         uint8_t *raw = buf->data;
         memmove(raw + dst_y * buf->stride,
                 raw + src_y * buf->stride,
                 height * buf->stride);
+        term->stats.scroll.memmove++;
     }
 
 #if TIME_SCROLL_DAMAGE
@@ -1019,8 +1209,8 @@ grid_render_scroll(struct terminal *term, struct buffer *buf,
              (long)memmove_time.tv_sec, memmove_time.tv_nsec);
 #endif
 
-    wl_surface_damage_buffer(
-        term->window->surface.surf, term->margins.left, dst_y,
+    damage_main_surface(
+        term, term->margins.left, dst_y,
         term->width - term->margins.left - term->margins.right, height);
 
     /*
@@ -1076,12 +1266,14 @@ grid_render_scroll_reverse(struct terminal *term, struct buffer *buf,
         /* Restore margins */
         render_margin(
             term, buf, dmg->region.start, dmg->region.start + dmg->lines, false);
+        term->stats.scroll.shm++;
     } else {
         /* Fallback for when we either cannot do SHM scrolling, or it failed */
         uint8_t *raw = buf->data;
         memmove(raw + dst_y * buf->stride,
                 raw + src_y * buf->stride,
                 height * buf->stride);
+        term->stats.scroll.memmove++;
     }
 
 #if TIME_SCROLL_DAMAGE
@@ -1096,8 +1288,8 @@ grid_render_scroll_reverse(struct terminal *term, struct buffer *buf,
              (long)memmove_time.tv_sec, memmove_time.tv_nsec);
 #endif
 
-    wl_surface_damage_buffer(
-        term->window->surface.surf, term->margins.left, dst_y,
+    damage_main_surface(
+        term, term->margins.left, dst_y,
         term->width - term->margins.left - term->margins.right, height);
 
     /*
@@ -1146,7 +1338,7 @@ render_sixel_chunk(struct terminal *term, pixman_image_t *pix, const struct sixe
         x, y,
         width, height);
 
-    wl_surface_damage_buffer(term->window->surface.surf, x, y, width, height);
+    damage_main_surface(term, x, y, width, height);
 }
 
 static void
@@ -1283,6 +1475,201 @@ render_sixel(struct terminal *term, pixman_image_t *pix,
 #undef maybe_emit_sixel_chunk_then_reset
 }
 
+static int
+sixel_scaler_thread(void *data)
+{
+    struct terminal *term = data;
+
+    sigset_t mask;
+    sigfillset(&mask);
+    pthread_sigmask(SIG_SETMASK, &mask, NULL);
+
+    if (pthread_setname_np(pthread_self(), "foot:sixel") < 0)
+        LOG_ERRNO("sixel scaler: failed to set process title");
+
+    mtx_t *lock = &term->render.sixel_scaler.lock;
+    cnd_t *cond = &term->render.sixel_scaler.cond;
+
+    mtx_lock(lock);
+
+    while (true) {
+        while (tll_length(term->render.sixel_scaler.queue) == 0 &&
+               !term->render.sixel_scaler.quit)
+        {
+            cnd_wait(cond, lock);
+        }
+
+        if (term->render.sixel_scaler.quit)
+            break;
+
+        struct sixel_scale_job *job =
+            tll_pop_front(term->render.sixel_scaler.queue);
+        mtx_unlock(lock);
+
+        sixel_scale_job_run(job);
+
+        mtx_lock(lock);
+        tll_push_back(term->render.sixel_scaler.done, job);
+
+        if (write(term->render.sixel_scaler.event_fd,
+                  &(uint64_t){1}, sizeof(uint64_t)) != sizeof(uint64_t))
+        {
+            LOG_ERRNO("sixel scaler: failed to signal main thread");
+        }
+    }
+
+    mtx_unlock(lock);
+    return 0;
+}
+
+static bool
+fdm_sixel_scaler_done(struct fdm *fdm, int fd, int events, void *data)
+{
+    struct terminal *term = data;
+
+    if (events & EPOLLHUP)
+        return false;
+
+    uint64_t count;
+    if (read(fd, &count, sizeof(count)) < 0) {
+        if (errno == EAGAIN)
+            return true;
+
+        LOG_ERRNO("sixel scaler: failed to read event FD");
+        return false;
+    }
+
+    mtx_lock(&term->render.sixel_scaler.lock);
+    tll(struct sixel_scale_job *) done = tll_init();
+    tll_foreach(term->render.sixel_scaler.done, it) {
+        tll_push_back(done, it->item);
+        tll_remove(term->render.sixel_scaler.done, it);
+    }
+    mtx_unlock(&term->render.sixel_scaler.lock);
+
+    bool refresh = false;
+    tll_foreach(done, it) {
+        refresh |= sixel_scale_job_apply(term, it->item);
+        sixel_scale_job_destroy(it->item);
+        tll_remove(done, it);
+    }
+
+    if (refresh)
+        render_refresh(term);
+    return true;
+}
+
+static bool
+sixel_scaler_start(struct terminal *term)
+{
+    xassert(!term->render.sixel_scaler.started);
+
+    int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (event_fd < 0) {
+        LOG_ERRNO("failed to create sixel scaler event FD");
+        return false;
+    }
+
+    int err;
+    if ((err = mtx_init(&term->render.sixel_scaler.lock, mtx_plain)) != thrd_success) {
+        LOG_ERR("failed to instantiate sixel scaler mutex: %s (%d)",
+                thrd_err_as_string(err), err);
+        goto err_close_fd;
+    }
+
+    if ((err = cnd_init(&term->render.sixel_scaler.cond)) != thrd_success) {
+        LOG_ERR("failed to instantiate sixel scaler condition variable: %s (%d)",
+                thrd_err_as_string(err), err);
+        goto err_mtx_destroy;
+    }
+
+    if (!fdm_add(term->fdm, event_fd, EPOLLIN, &fdm_sixel_scaler_done, term))
+        goto err_cnd_destroy;
+
+    term->render.sixel_scaler.event_fd = event_fd;
+    term->render.sixel_scaler.quit = false;
+
+    if ((err = thrd_create(&term->render.sixel_scaler.thread,
+                           &sixel_scaler_thread, term)) != thrd_success)
+    {
+        LOG_ERR("failed to create sixel scaler thread: %s (%d)",
+                thrd_err_as_string(err), err);
+        fdm_del(term->fdm, event_fd);
+        term->render.sixel_scaler.event_fd = -1;
+        cnd_destroy(&term->render.sixel_scaler.cond);
+        mtx_destroy(&term->render.sixel_scaler.lock);
+        return false;
+    }
+
+    term->render.sixel_scaler.started = true;
+    return true;
+
+err_cnd_destroy:
+    cnd_destroy(&term->render.sixel_scaler.cond);
+err_mtx_destroy:
+    mtx_destroy(&term->render.sixel_scaler.lock);
+err_close_fd:
+    close(event_fd);
+    return false;
+}
+
+static void
+sixel_scaler_queue(struct terminal *term, const struct sixel *six)
+{
+    struct sixel_scale_job *job = sixel_scale_job_new(term, six);
+
+    if (!term->render.sixel_scaler.started &&
+        (term->render.sixel_scaler.failed || !sixel_scaler_start(term)))
+    {
+        /* Fallback: scale synchronously (don’t retry starting the thread) */
+        term->render.sixel_scaler.failed = true;
+        sixel_scale_job_run(job);
+        sixel_scale_job_apply(term, job);
+        sixel_scale_job_destroy(job);
+        return;
+    }
+
+    mtx_lock(&term->render.sixel_scaler.lock);
+
+    /* Drop queued jobs for an old cell size; they would be discarded anyway */
+    tll_foreach(term->render.sixel_scaler.queue, it) {
+        if (it->item->cell_width != job->cell_width ||
+            it->item->cell_height != job->cell_height)
+        {
+            sixel_scale_job_destroy(it->item);
+            tll_remove(term->render.sixel_scaler.queue, it);
+        }
+    }
+
+    tll_push_back(term->render.sixel_scaler.queue, job);
+    cnd_signal(&term->render.sixel_scaler.cond);
+    mtx_unlock(&term->render.sixel_scaler.lock);
+}
+
+void
+render_sixel_scaler_destroy(struct terminal *term)
+{
+    if (!term->render.sixel_scaler.started)
+        return;
+
+    mtx_lock(&term->render.sixel_scaler.lock);
+    term->render.sixel_scaler.quit = true;
+    cnd_signal(&term->render.sixel_scaler.cond);
+    mtx_unlock(&term->render.sixel_scaler.lock);
+
+    thrd_join(term->render.sixel_scaler.thread, NULL);
+
+    fdm_del(term->fdm, term->render.sixel_scaler.event_fd);
+    term->render.sixel_scaler.event_fd = -1;
+
+    tll_free_and_free(term->render.sixel_scaler.queue, sixel_scale_job_destroy);
+    tll_free_and_free(term->render.sixel_scaler.done, sixel_scale_job_destroy);
+
+    cnd_destroy(&term->render.sixel_scaler.cond);
+    mtx_destroy(&term->render.sixel_scaler.lock);
+    term->render.sixel_scaler.started = false;
+}
+
 static void
 render_sixel_images(struct terminal *term, pixman_image_t *pix,
                     const struct coord *cursor)
@@ -1304,7 +1691,7 @@ render_sixel_images(struct terminal *term, pixman_image_t *pix,
     //        tll_length(term->grid->sixel_images), view_start, view_end);
 
     tll_foreach(term->grid->sixel_images, it) {
-        const struct sixel *six = &it->item;
+        struct sixel *six = &it->item;
         const int start
             = (six->pos.row
                - scrollback_end
@@ -1312,17 +1699,30 @@ render_sixel_images(struct terminal *term, pixman_image_t *pix,
         const int end = start + six->rows - 1;
 
         //LOG_DBG("  sixel: %d-%d", start, end);
-        if (start > view_end) {
-            /* Sixel starts after view ends, no need to try to render it */
+        if (start > view_end || end < view_start) {
+            /*
+             * Not visible. Free rescaled copies of images more than
+             * a screen away from the view; they are re-created if
+             * the image is scrolled back into view.
+             *
+             * Note that we can't stop at the first image before the
+             * view, since we need to check them all.
+             */
+            if (six->scaled.data != NULL &&
+                (start > view_end + term->rows ||
+                 end < view_start - term->rows))
+            {
+                sixel_invalidate_cache(six);
+            }
             continue;
-        } else if (end < view_start) {
-            /* Image ends before view starts. Since the image list is
-             * sorted, we can safely stop here */
-            break;
         }
 
-        sixel_sync_cache(term, &it->item);
-        render_sixel(term, pix, cursor, &it->item);
+        if (sixel_sync_cache(term, six)) {
+            /* Showing a preview; scale properly in the background */
+            sixel_scaler_queue(term, six);
+        }
+
+        render_sixel(term, pix, cursor, six);
     }
 }
 
@@ -1477,8 +1877,8 @@ render_ime_preedit_for_seat(struct terminal *term, struct seat *seat,
         row->cells[col_idx + i] = real_cells[i];
     free(real_cells);
 
-    wl_surface_damage_buffer(
-        term->window->surface.surf,
+    damage_main_surface(
+        term,
         term->margins.left,
         term->margins.top + row_idx * term->cell_height,
         term->width - term->margins.left - term->margins.right,
@@ -1497,6 +1897,45 @@ render_ime_preedit(struct terminal *term, struct buffer *buf)
 #endif
 }
 
+static bool
+search_match_spans_equal(const struct search_match_spans *a,
+                         const struct search_match_spans *b)
+{
+    return a->count == b->count &&
+           (a->count == 0 ||
+            memcmp(a->v, b->v, a->count * sizeof(a->v[0])) == 0);
+}
+
+/* Ensure we have per-row match spans for all rows in the view */
+static void
+search_match_spans_resize(struct terminal *term)
+{
+    const int old_count = term->render.last_overlay_matches.count;
+    const int new_count = term->rows;
+
+    if (old_count == new_count)
+        return;
+
+    for (int i = new_count; i < old_count; i++) {
+        free(term->render.last_overlay_matches.rows[i].v);
+        free(term->render.last_overlay_matches.next[i].v);
+    }
+
+    struct search_match_spans *rows = xrealloc(
+        term->render.last_overlay_matches.rows, new_count * sizeof(rows[0]));
+    struct search_match_spans *next = xrealloc(
+        term->render.last_overlay_matches.next, new_count * sizeof(next[0]));
+
+    for (int i = old_count; i < new_count; i++) {
+        rows[i] = (struct search_match_spans){0};
+        next[i] = (struct search_match_spans){0};
+    }
+
+    term->render.last_overlay_matches.rows = rows;
+    term->render.last_overlay_matches.next = next;
+    term->render.last_overlay_matches.count = new_count;
+}
+
 static void
 render_overlay(struct terminal *term)
 {
@@ -1554,134 +1993,104 @@ render_overlay(struct terminal *term)
         break;
     }
 
-    /* Bounding rectangle of damaged areas - for wl_surface_damage_buffer() */
-    pixman_box32_t damage_bounds;
+    /* Damaged areas - for wl_surface_damage_buffer() */
+    pixman_region32_t damage;
+    pixman_region32_init(&damage);
 
     if (style == OVERLAY_SEARCH) {
         /*
-         * When possible, we only update the areas that have *changed*
-         * since the last frame. That means:
-         *
-         *  - clearing/erasing cells that are now selected, but weren’t
-         *    in the last frame
-         *  - dimming cells that were selected, but aren’t anymore
-         *
-         * To do this, we save the last frame’s selected cells as a
-         * pixman region.
+         * When possible, we only update the rows whose set of search
+         * matches have *changed* since the last frame. Each such row
+         * is dimmed, except for the cells covered by a match, which
+         * are cleared.
          *
-         * Then, we calculate the corresponding region for this
-         * frame’s selected cells.
+         * To do this, we save the last frame’s matches, per view
+         * row, and compare them with this frame’s matches.
          *
-         * Last frame’s region minus this frame’s region gives us the
-         * region that needs to be *dimmed* in this frame
-         *
-         * This frame’s region minus last frame’s region gives us the
-         * region that needs to be *cleared* in this frame.
-         *
-         * Finally, the union of the two “diff” regions above, gives
-         * us the total region affected by a change, in either way. We
-         * use this as the bounding box for the
-         * wl_surface_damage_buffer() call.
+         * The union of all changed rows is also used as the damage
+         * region.
          */
-        pixman_region32_t *see_through = &term->render.last_overlay_clip;
-        pixman_region32_t old_see_through;
         const bool buffer_reuse =
             buf == term->render.last_overlay_buf &&
             style == term->render.last_overlay_style &&
-            buf->age == 0;
+            buf->age == 0 &&
+            term->render.last_overlay_matches.count == term->rows;
+
+        search_match_spans_resize(term);
+        struct search_match_spans *old_matches = term->render.last_overlay_matches.rows;
+        struct search_match_spans *new_matches = term->render.last_overlay_matches.next;
+
+        search_matches_in_view(term, new_matches);
+
+        /* Areas that need to be cleared: match spans on changed rows */
+        pixman_region32_t see_through;
+        pixman_region32_init(&see_through);
 
         if (!buffer_reuse) {
-            /* Can’t re-use last frame’s damage - set to full window,
-             * to ensure *everything* is updated */
-            pixman_region32_init_rect(
-                &old_see_through, 0, 0, buf->width, buf->height);
-        } else {
-            /* Use last frame’s saved region */
-            pixman_region32_init(&old_see_through);
-            pixman_region32_copy(&old_see_through, see_through);
+            /* Buffer content is unknown - update *everything* */
+            damage_add(term, &damage, 0, 0, buf->width, buf->height);
         }
 
-        pixman_region32_clear(see_through);
+        for (int r = 0; r < term->rows; r++) {
+            if (buffer_reuse &&
+                search_match_spans_equal(&old_matches[r], &new_matches[r]))
+            {
+                continue;
+            }
 
-        /* Build region consisting of all current search matches */
-        struct search_match_iterator iter = search_matches_new_iter(term);
-        for (struct range match = search_matches_next(&iter);
-             match.start.row >= 0;
-             match = search_matches_next(&iter))
-        {
-            int r = match.start.row;
-            int start_col = match.start.col;
-            const int end_row = match.end.row;
+            const int y = term->margins.top + r * term->cell_height;
 
-            while (true) {
-                const int end_col =
-                    r == end_row ? match.end.col : term->cols - 1;
+            damage_add(term, &damage, 0, y, buf->width, term->cell_height);
 
-                int x = term->margins.left + start_col * term->cell_width;
-                int y = term->margins.top + r * term->cell_height;
-                int width = (end_col + 1 - start_col) * term->cell_width;
-                int height = 1 * term->cell_height;
+            for (size_t i = 0; i < new_matches[r].count; i++) {
+                const struct search_match_span *span = &new_matches[r].v[i];
+                const int x = term->margins.left + span->start * term->cell_width;
+                const int width = (span->end + 1 - span->start) * term->cell_width;
 
                 pixman_region32_union_rect(
-                    see_through, see_through, x, y, width, height);
-
-                if (++r > end_row)
-                    break;
-
-                start_col = 0;
+                    &see_through, &see_through, x, y, width, term->cell_height);
             }
         }
 
-        /* Areas that need to be cleared: cells that were dimmed in
-         * the last frame but is now see-through */
-        pixman_region32_t new_see_through;
-        pixman_region32_init(&new_see_through);
+        /* This frame’s matches are next frame’s old matches */
+        term->render.last_overlay_matches.rows = new_matches;
+        term->render.last_overlay_matches.next = old_matches;
 
-        if (buffer_reuse)
-            pixman_region32_subtract(&new_see_through, see_through, &old_see_through);
-        else {
-            /* Buffer content is unknown - explicitly clear *all*
-             * current see-through areas */
-            pixman_region32_copy(&new_see_through, see_through);
+        if (!pixman_region32_not_empty(&damage)) {
+            /* No row changed */
+            pixman_region32_fini(&see_through);
+            pixman_region32_fini(&damage);
+            shm_did_not_use_buf(buf);
+            return;
         }
-        pixman_image_set_clip_region32(buf->pix[0], &new_see_through);
-
-        /* Areas that need to be dimmed: cells that were cleared in
-         * the last frame but is not anymore */
-        pixman_region32_t new_dimmed;
-        pixman_region32_init(&new_dimmed);
-        pixman_region32_subtract(&new_dimmed, &old_see_through, see_through);
-        pixman_region32_fini(&old_see_through);
-
-        /* Total affected area */
-        pixman_region32_t damage;
-        pixman_region32_init(&damage);
-        pixman_region32_union(&damage, &new_see_through, &new_dimmed);
-        damage_bounds = damage.extents;
-
-        /* Clear cells that became selected in this frame. */
+
+        /* Clear cells that are covered by a match */
+        pixman_image_set_clip_region32(buf->pix[0], &see_through);
         pixman_image_fill_rectangles(
             PIXMAN_OP_SRC, buf->pix[0], &(pixman_color_t){0}, 1,
             &(pixman_rectangle16_t){0, 0, term->width, term->height});
 
-        /* Set clip region for the newly dimmed cells. The actual
-         * paint call is done below */
-        pixman_image_set_clip_region32(buf->pix[0], &new_dimmed);
+        /* Set clip region for the dimmed cells: everything else on
+         * the changed rows. The actual paint call is done below */
+        pixman_region32_t dimmed;
+        pixman_region32_init(&dimmed);
+        pixman_region32_subtract(&dimmed, &damage, &see_through);
+        pixman_image_set_clip_region32(buf->pix[0], &dimmed);
 
-        pixman_region32_fini(&new_see_through);
-        pixman_region32_fini(&new_dimmed);
-        pixman_region32_fini(&damage);
+        pixman_region32_fini(&dimmed);
+        pixman_region32_fini(&see_through);
     }
 
     else if (buf == term->render.last_overlay_buf &&
              style == term->render.last_overlay_style)
     {
         xassert(style == OVERLAY_FLASH || style == OVERLAY_UNICODE_MODE);
+        pixman_region32_fini(&damage);
         shm_did_not_use_buf(buf);
         return;
     } else {
         pixman_image_set_clip_region32(buf->pix[0], NULL);
-        damage_bounds = (pixman_box32_t){0, 0, buf->width, buf->height};
+        damage_add(term, &damage, 0, 0, buf->width, buf->height);
     }
 
     pixman_image_fill_rectangles(
@@ -1694,11 +2103,8 @@ render_overlay(struct terminal *term)
     wl_subsurface_set_position(overlay->sub, 0, 0);
     wl_surface_attach(overlay->surface.surf, buf->wl_buf, 0, 0);
 
-    wl_surface_damage_buffer(
-        overlay->surface.surf,
-        damage_bounds.x1, damage_bounds.y1,
-        damage_bounds.x2 - damage_bounds.x1,
-        damage_bounds.y2 - damage_bounds.y1);
+    damage_submit(term, overlay->surface.surf, &damage);
+    pixman_region32_fini(&damage);
 
     wl_surface_commit(overlay->surface.surf);
     quirk_weston_subsurface_desync_off(overlay->sub);
@@ -1738,7 +2144,7 @@ render_worker_thread(void *_ctx)
 
         /* Translate offset-relative cursor row to view-relative */
         struct coord cursor = {-1, -1};
-        if (!term->hide_cursor) {
+        if (!term->hide_cursor && !term->render.cursor_surface.active) {
             cursor = term->grid->cursor.point;
             cursor.row += term->grid->offset;
             cursor.row -= term->grid->view;
@@ -1848,26 +2254,12 @@ render_csd_part(struct terminal *term,
 }
 
 static void
-render_osd(struct terminal *term, const struct wayl_sub_surface *sub_surf,
-           struct fcft_font *font, struct buffer *buf,
-           const char32_t *text, uint32_t _fg, uint32_t _bg,
-           unsigned x, unsigned y)
+render_osd_line(struct terminal *term, struct fcft_font *font,
+                struct buffer *buf, pixman_image_t *src,
+                const char32_t *text, size_t len, unsigned x, unsigned y)
 {
-    pixman_region32_t clip;
-    pixman_region32_init_rect(&clip, 0, 0, buf->width, buf->height);
-    pixman_image_set_clip_region32(buf->pix[0], &clip);
-    pixman_region32_fini(&clip);
-
-    uint16_t alpha = _bg >> 24 | (_bg >> 24 << 8);
-    pixman_color_t bg = color_hex_to_pixman_with_alpha(_bg, alpha);
-    pixman_image_fill_rectangles(
-        PIXMAN_OP_SRC, buf->pix[0], &bg, 1,
-        &(pixman_rectangle16_t){0, 0, buf->width, buf->height});
-
-    pixman_color_t fg = color_hex_to_pixman(_fg);
     const int x_ofs = term->font_x_ofs;
 
-    const size_t len = c32len(text);
     struct fcft_text_run *text_run = NULL;
     const struct fcft_glyph **glyphs = NULL;
     const struct fcft_glyph *_glyphs[len];
@@ -1897,8 +2289,6 @@ render_osd(struct terminal *term, const struct wayl_sub_surface *sub_surf,
         glyphs = _glyphs;
     }
 
-    pixman_image_t *src = pixman_image_create_solid_fill(&fg);
-
     for (size_t i = 0; i < glyph_count; i++) {
         const struct fcft_glyph *glyph = glyphs[i];
 
@@ -1918,6 +2308,100 @@ render_osd(struct terminal *term, const struct wayl_sub_surface *sub_surf,
     }
 
     fcft_text_run_destroy(text_run);
+}
+
+static void
+osd_cache_reset(struct wayl_osd_cache *cache)
+{
+    free(cache->text);
+    *cache = (struct wayl_osd_cache){0};
+}
+
+/*
+ * Returns true if ‘sub_surf’ already shows ‘text’, rendered with the
+ * specified font, colors and size, at the current scale.
+ */
+static bool
+osd_cache_matches(const struct terminal *term,
+                  const struct wayl_sub_surface *sub_surf,
+                  const struct fcft_font *font, const char32_t *text,
+                  uint32_t fg, uint32_t bg, int width, int height)
+{
+    const struct wayl_osd_cache *cache = &sub_surf->osd;
+
+    return cache->text != NULL &&
+           cache->font == font &&
+           cache->font_generation == term->font_generation &&
+           cache->subpixel == term->font_subpixel &&
+           cache->fg == fg &&
+           cache->bg == bg &&
+           cache->width == width &&
+           cache->height == height &&
+           cache->scale == term->scale &&
+           c32cmp(cache->text, text) == 0;
+}
+
+static void
+osd_cache_update(const struct terminal *term, struct wayl_sub_surface *sub_surf,
+                 const struct fcft_font *font, const char32_t *text,
+                 uint32_t fg, uint32_t bg, int width, int height)
+{
+    struct wayl_osd_cache *cache = &sub_surf->osd;
+
+    if (cache->text == NULL || c32cmp(cache->text, text) != 0) {
+        free(cache->text);
+        cache->text = xc32dup(text);
+    }
+
+    cache->font = font;
+    cache->font_generation = term->font_generation;
+    cache->subpixel = term->font_subpixel;
+    cache->fg = fg;
+    cache->bg = bg;
+    cache->width = width;
+    cache->height = height;
+    cache->scale = term->scale;
+}
+
+/*
+ * Renders ‘text’ to a sub-surface. ‘text’ may contain newlines, in
+ * which case each line is rendered ‘term->cell_height’ pixels below
+ * the previous one.
+ *
+ * The rendered content is recorded in the sub-surface's OSD cache,
+ * see osd_cache_matches().
+ */
+static void
+render_osd(struct terminal *term, struct wayl_sub_surface *sub_surf,
+           struct fcft_font *font, struct buffer *buf,
+           const char32_t *text, uint32_t _fg, uint32_t _bg,
+           unsigned x, unsigned y)
+{
+    pixman_region32_t clip;
+    pixman_region32_init_rect(&clip, 0, 0, buf->width, buf->height);
+    pixman_image_set_clip_region32(buf->pix[0], &clip);
+    pixman_region32_fini(&clip);
+
+    uint16_t alpha = _bg >> 24 | (_bg >> 24 << 8);
+    pixman_color_t bg = color_hex_to_pixman_with_alpha(_bg, alpha);
+    pixman_image_fill_rectangles(
+        PIXMAN_OP_SRC, buf->pix[0], &bg, 1,
+        &(pixman_rectangle16_t){0, 0, buf->width, buf->height});
+
+    pixman_color_t fg = color_hex_to_pixman(_fg);
+    pixman_image_t *src = pixman_image_create_solid_fill(&fg);
+
+    for (const char32_t *line = text; ; y += term->cell_height) {
+        const char32_t *nl = c32chr(line, U'\n');
+        const size_t len = nl != NULL ? nl - line : c32len(line);
+
+        render_osd_line(term, font, buf, src, line, len, x, y);
+
+        if (nl == NULL)
+            break;
+        line = nl + 1;
+    }
+
     pixman_image_unref(src);
     pixman_image_set_clip_region32(buf->pix[0], NULL);
 
@@ -1935,32 +2419,37 @@ render_osd(struct terminal *term, const struct wayl_sub_surface *sub_surf,
 
     wl_surface_commit(sub_surf->surface.surf);
     quirk_weston_subsurface_desync_off(sub_surf->sub);
+
+    osd_cache_update(
+        term, sub_surf, font, text, _fg, _bg, buf->width, buf->height);
 }
 
 static void
-render_csd_title(struct terminal *term, const struct csd_data *info,
-                 struct buffer *buf)
+csd_title_colors(const struct terminal *term, uint32_t *fg, uint32_t *bg)
 {
-    xassert(term->window->csd_mode == CSD_YES);
-
-    struct wayl_sub_surface *surf = &term->window->csd.surface[CSD_SURF_TITLE];
-    if (info->width == 0 || info->height == 0)
-        return;
-
-    uint32_t bg = term->conf->csd.color.title_set
+    *bg = term->conf->csd.color.title_set
         ? term->conf->csd.color.title
         : 0xffu << 24 | term->conf->colors.fg;
-    uint32_t fg = term->conf->csd.color.buttons_set
+    *fg = term->conf->csd.color.buttons_set
         ? term->conf->csd.color.buttons
         : term->conf->colors.bg;
 
     if (!term->visual_focus) {
-        bg = color_dim(term, bg);
-        fg = color_dim(term, fg);
+        *bg = color_dim(term, *bg);
+        *fg = color_dim(term, *fg);
     }
+}
 
-    char32_t *_title_text = ambstoc32(term->window_title);
-    const char32_t *title_text = _title_text != NULL ? _title_text : U"";
+static void
+render_csd_title(struct terminal *term, const struct csd_data *info,
+                 struct buffer *buf, const char32_t *title_text,
+                 uint32_t fg, uint32_t bg)
+{
+    xassert(term->window->csd_mode == CSD_YES);
+
+    struct wayl_sub_surface *surf = &term->window->csd.surface[CSD_SURF_TITLE];
+    if (info->width == 0 || info->height == 0)
+        return;
 
     struct wl_window *win = term->window;
 
@@ -1973,7 +2462,6 @@ render_csd_title(struct terminal *term, const struct csd_data *info,
                (buf->height - win->csd.font->height) / 2);
 
     csd_commit(term, &surf->surface, buf);
-    free(_title_text);
 }
 
 static void
@@ -2366,6 +2854,7 @@ render_csd(struct terminal *term)
             wl_subsurface_set_position(sub, 0, 0);
             wl_surface_attach(surf, NULL, 0, 0);
             wl_surface_commit(surf);
+            osd_cache_reset(&term->window->csd.surface[i].osd);
             continue;
         }
 
@@ -2375,6 +2864,26 @@ render_csd(struct terminal *term)
         wl_subsurface_set_position(sub, x / term->scale, y / term->scale);
     }
 
+    /*
+     * Applications may update the title at a high rate (e.g. progress
+     * indicators). Don’t re-shape, re-allocate and re-commit the
+     * title bar unless its content actually changed; the compositor
+     * keeps showing the previously committed buffer.
+     */
+    char32_t *_title_text = ambstoc32(term->window_title);
+    const char32_t *title_text = _title_text != NULL ? _title_text : U"";
+
+    uint32_t title_fg, title_bg;
+    csd_title_colors(term, &title_fg, &title_bg);
+
+    const bool title_is_cached = osd_cache_matches(
+        term, &term->window->csd.surface[CSD_SURF_TITLE],
+        term->window->csd.font, title_text, title_fg, title_bg,
+        widths[CSD_SURF_TITLE], heights[CSD_SURF_TITLE]);
+
+    if (title_is_cached)
+        widths[CSD_SURF_TITLE] = heights[CSD_SURF_TITLE] = 0;
+
     struct buffer *bufs[CSD_SURF_COUNT];
     shm_get_many(term->render.chains.csd, CSD_SURF_COUNT, widths, heights, bufs);
 
@@ -2382,7 +2891,18 @@ render_csd(struct terminal *term)
         render_csd_border(term, i, &infos[i], bufs[i]);
     for (size_t i = CSD_SURF_MINIMIZE; i <= CSD_SURF_CLOSE; i++)
         render_csd_button(term, i, &infos[i], bufs[i]);
-    render_csd_title(term, &infos[CSD_SURF_TITLE], bufs[CSD_SURF_TITLE]);
+
+    if (title_is_cached) {
+        /* The buttons are synchronized sub-surfaces of the title bar;
+         * their new state is applied when the title bar is committed */
+        wl_surface_commit(
+            term->window->csd.surface[CSD_SURF_TITLE].surface.surf);
+    } else {
+        render_csd_title(term, &infos[CSD_SURF_TITLE], bufs[CSD_SURF_TITLE],
+                         title_text, title_fg, title_bg);
+    }
+
+    free(_title_text);
 }
 
 static void
@@ -2529,63 +3049,388 @@ render_scrollback_position(struct terminal *term)
         bg = term->conf->colors.scrollback_indicator.bg;
     }
 
-    render_osd(
-        term,
-        &win->scrollback_indicator,
-        term->fonts[0], buf, text,
-        fg, 0xffu << 24 | bg,
-        width - margin - c32len(text) * term->cell_width, margin);
+    render_osd(
+        term,
+        &win->scrollback_indicator,
+        term->fonts[0], buf, text,
+        fg, 0xffu << 24 | bg,
+        width - margin - c32len(text) * term->cell_width, margin);
+}
+
+static void
+render_render_timer(struct terminal *term, struct timespec render_time)
+{
+    struct wl_window *win = term->window;
+
+    char usecs_str[256];
+    double usecs = render_time.tv_sec * 1000000 + render_time.tv_nsec / 1000.0;
+    snprintf(usecs_str, sizeof(usecs_str), "%.2f µs", usecs);
+
+    char32_t text[256];
+    mbstoc32(text, usecs_str, ALEN(text));
+
+    const int scale = round(term->scale);
+    const int cell_count = c32len(text);
+    const int margin = 3 * scale;
+    const int width =
+        (2 * margin + cell_count * term->cell_width + scale - 1) / scale * scale;
+    const int height =
+        (2 * margin + term->cell_height + scale - 1) / scale * scale;
+
+    struct buffer_chain *chain = term->render.chains.render_timer;
+    struct buffer *buf = shm_get_buffer(chain, width, height);
+
+    wl_subsurface_set_position(
+        win->render_timer.sub,
+        margin / term->scale,
+        (term->margins.top + term->cell_height - margin) / term->scale);
+
+    render_osd(
+        term,
+        &win->render_timer,
+        term->fonts[0], buf, text,
+        term->colors.table[0], 0xffu << 24 | term->colors.table[8 + 1],
+        margin, margin);
+}
+
+static void
+render_stats(struct terminal *term)
+{
+    struct wl_window *win = term->window;
+
+    if (!term->render.stats) {
+        if (win->stats.surface.surf != NULL) {
+            wayl_win_subsurface_destroy(&win->stats);
+            quirk_sway_subsurface_unmap(term);
+        }
+        return;
+    }
+
+    if (win->stats.surface.surf == NULL) {
+        if (!wayl_win_subsurface_new(win, &win->stats, false)) {
+            LOG_ERR("failed to create statistics overlay surface");
+            return;
+        }
+    }
+
+    char *mbs = stats_to_text(term);
+    char32_t *text = ambstoc32(mbs);
+    free(mbs);
+
+    if (text == NULL)
+        return;
+
+    /* Size the surface after the longest line */
+    int line_count = 1;
+    int cell_count = 0;
+    for (const char32_t *line = text; ; line_count++) {
+        const char32_t *nl = c32chr(line, U'\n');
+        const size_t len = nl != NULL ? nl - line : c32len(line);
+
+        cell_count = max(cell_count, (int)len);
+
+        if (nl == NULL)
+            break;
+        line = nl + 1;
+    }
+
+    const int scale = round(term->scale);
+    const int margin = 3 * scale;
+    const int width =
+        (2 * margin + cell_count * term->cell_width + scale - 1) / scale * scale;
+    const int height =
+        (2 * margin + line_count * term->cell_height + scale - 1) / scale * scale;
+
+    /* Below the render timer, if that is visible */
+    int y = term->margins.top + term->cell_height - margin;
+    if (term->conf->tweak.render_timer == RENDER_TIMER_OSD ||
+        term->conf->tweak.render_timer == RENDER_TIMER_BOTH)
+    {
+        y += 2 * margin + term->cell_height;
+    }
+
+    if (y + height > term->height) {
+        wl_surface_attach(win->stats.surface.surf, NULL, 0, 0);
+        wl_surface_commit(win->stats.surface.surf);
+        free(text);
+        return;
+    }
+
+    struct buffer_chain *chain = term->render.chains.stats;
+    struct buffer *buf = shm_get_buffer(chain, width, height);
+
+    wl_subsurface_set_position(
+        win->stats.sub, margin / term->scale, y / term->scale);
+
+    render_osd(
+        term, &win->stats, term->fonts[0], buf, text,
+        term->colors.fg, 0xffu << 24 | term->colors.bg,
+        margin, margin);
+
+    free(text);
+}
+
+static void frame_callback(
+    void *data, struct wl_callback *wl_callback, uint32_t callback_data);
+
+static const struct wl_callback_listener frame_listener = {
+    .done = &frame_callback,
+};
+
+static void
+force_full_repaint(struct terminal *term, struct buffer *buf)
+{
+    term->grid->scroll_damage.count = 0;
+    render_margin(term, buf, 0, term->rows, true);
+    term_damage_view(term);
+}
+
+/*
+ * The normal screen's pixels, saved while the alternate screen is
+ * active. When switching back, they are copied to the new frame,
+ * instead of re-rendering the entire normal screen. Normal screen
+ * cells modified in the meantime are still dirty, and are rendered
+ * on top, as usual.
+ *
+ * Things that affect the rendering of *all* cells (colors, reverse
+ * video etc) only dirty the active grid. Thus, we record the state
+ * each normal screen frame is rendered with, and fall back to a full
+ * repaint if it has changed when switching back.
+ *
+ * Frames rendered from the URL mode snapshot are neither; nothing is
+ * saved, or restored, while URL mode is active.
+ */
+struct normal_screen_frame {
+    bool valid;
+    __typeof__(((struct terminal *)NULL)->colors) colors;
+    __typeof__(((struct terminal *)NULL)->blink.state) blink;
+    bool reverse;
+    int offset;
+    int view;
+    struct coord cursor;  /* View relative, or -1 if not rendered */
+};
+
+struct normal_screen {
+    enum {
+        NORMAL_SCREEN_IDLE,
+        NORMAL_SCREEN_SAVE,     /* Alt screen entered, but not yet rendered */
+        NORMAL_SCREEN_SAVED,    /* ‘pix’ holds the normal screen */
+        NORMAL_SCREEN_RESTORE,  /* Alt screen exited; restore ‘pix’ */
+        NORMAL_SCREEN_KEEP,     /* Alt screen exited without being rendered */
+    } state;
+
+    pixman_image_t *pix;
+
+    struct normal_screen_frame last;   /* Invalid if not a normal screen frame */
+    struct normal_screen_frame saved;  /* The frame in ‘pix’ */
+};
+
+static void
+normal_screen_discard(struct normal_screen *ns)
+{
+    if (ns->pix != NULL) {
+        pixman_image_unref(ns->pix);
+        ns->pix = NULL;
+    }
+
+    ns->state = NORMAL_SCREEN_IDLE;
+}
+
+void
+render_normal_screen_destroy(struct terminal *term)
+{
+    struct normal_screen *ns = term->render.normal_screen;
+    if (ns == NULL)
+        return;
+
+    normal_screen_discard(ns);
+    free(ns);
+    term->render.normal_screen = NULL;
+}
+
+void
+render_alt_screen_entered(struct terminal *term)
+{
+    struct normal_screen *ns = term->render.normal_screen;
+    if (ns == NULL)
+        return;
+
+    if (urls_mode_is_active(term)) {
+        normal_screen_discard(ns);
+        return;
+    }
+
+    switch (ns->state) {
+    case NORMAL_SCREEN_RESTORE:
+        /* Never restored; ‘pix’ is still the normal screen */
+        ns->state = NORMAL_SCREEN_SAVED;
+        break;
+
+    case NORMAL_SCREEN_KEEP:
+        /* Last frame is still the normal screen */
+        ns->state = NORMAL_SCREEN_SAVE;
+        break;
+
+    case NORMAL_SCREEN_IDLE:
+    case NORMAL_SCREEN_SAVE:
+    case NORMAL_SCREEN_SAVED:
+        normal_screen_discard(ns);
+
+        /* Pending scroll damage is dropped when switching screens */
+        if (ns->last.valid && term->normal.scroll_damage.count == 0)
+            ns->state = NORMAL_SCREEN_SAVE;
+        break;
+    }
+}
+
+void
+render_alt_screen_exited(struct terminal *term)
+{
+    struct normal_screen *ns = term->render.normal_screen;
+    const bool urls = urls_mode_is_active(term);
+
+    if (ns != NULL && !urls && ns->state == NORMAL_SCREEN_SAVE)
+        ns->state = NORMAL_SCREEN_KEEP;
+    else if (ns != NULL && !urls && ns->state == NORMAL_SCREEN_SAVED)
+        ns->state = NORMAL_SCREEN_RESTORE;
+    else {
+        if (ns != NULL)
+            normal_screen_discard(ns);
+        term_damage_view(term);
+    }
+}
+
+/* Records the state the current frame is rendered with */
+static void
+normal_screen_frame(struct terminal *term, struct coord cursor)
+{
+    struct normal_screen *ns = term->render.normal_screen;
+
+    if (term->grid != &term->normal) {
+        if (ns != NULL)
+            ns->last.valid = false;
+        return;
+    }
+
+    if (ns == NULL)
+        ns = term->render.normal_screen = xcalloc(1, sizeof(*ns));
+
+    ns->last.valid = true;
+    memcpy(&ns->last.colors, &term->colors, sizeof(ns->last.colors));
+    ns->last.blink = term->blink.state;
+    ns->last.reverse = term->reverse;
+    ns->last.offset = term->normal.offset;
+    ns->last.view = term->normal.view;
+    ns->last.cursor = cursor;
+}
+
+static bool
+normal_screen_frame_unchanged(const struct terminal *term,
+                              const struct normal_screen_frame *frame)
+{
+    return frame->valid &&
+           memcmp(&frame->colors, &term->colors, sizeof(frame->colors)) == 0 &&
+           frame->blink == term->blink.state &&
+           frame->reverse == term->reverse &&
+           frame->offset == term->normal.offset &&
+           frame->view == term->normal.view &&
+           term->normal.scroll_damage.count == 0;
+}
+
+/* Copies the last (normal screen) frame, before rendering the alt screen */
+static void
+normal_screen_save(struct terminal *term)
+{
+    struct normal_screen *ns = term->render.normal_screen;
+    if (ns == NULL || ns->state != NORMAL_SCREEN_SAVE)
+        return;
+
+    /* E.g. the URL mode snapshot */
+    if (term->grid != &term->alt) {
+        normal_screen_discard(ns);
+        return;
+    }
+
+    const struct buffer *last = term->render.last_buf;
+    if (last == NULL || !ns->last.valid) {
+        normal_screen_discard(ns);
+        return;
+    }
+
+    ns->pix = pixman_image_create_bits_no_clear(
+        pixman_image_get_format(last->pix[0]), last->width, last->height,
+        NULL, 0);
+
+    if (ns->pix == NULL) {
+        LOG_WARN("failed to save normal screen");
+        normal_screen_discard(ns);
+        return;
+    }
+
+    pixman_image_composite32(
+        PIXMAN_OP_SRC, last->pix[0], NULL, ns->pix,
+        0, 0, 0, 0, 0, 0, last->width, last->height);
+
+    ns->saved = ns->last;
+    ns->state = NORMAL_SCREEN_SAVED;
 }
 
+/* Restores the normal screen into ‘buf’, or falls back to a full repaint */
 static void
-render_render_timer(struct terminal *term, struct timespec render_time)
+normal_screen_restore(struct terminal *term, struct buffer *buf)
 {
-    struct wl_window *win = term->window;
-
-    char usecs_str[256];
-    double usecs = render_time.tv_sec * 1000000 + render_time.tv_nsec / 1000.0;
-    snprintf(usecs_str, sizeof(usecs_str), "%.2f µs", usecs);
+    struct normal_screen *ns = term->render.normal_screen;
+    if (ns == NULL ||
+        (ns->state != NORMAL_SCREEN_RESTORE && ns->state != NORMAL_SCREEN_KEEP))
+    {
+        return;
+    }
 
-    char32_t text[256];
-    mbstoc32(text, usecs_str, ALEN(text));
+    /*
+     * E.g. the URL mode snapshot. Entering URL mode damages the
+     * view, so the normal screen will be fully repainted anyway.
+     */
+    if (term->grid != &term->normal) {
+        normal_screen_discard(ns);
+        return;
+    }
 
-    const int scale = round(term->scale);
-    const int cell_count = c32len(text);
-    const int margin = 3 * scale;
-    const int width =
-        (2 * margin + cell_count * term->cell_width + scale - 1) / scale * scale;
-    const int height =
-        (2 * margin + term->cell_height + scale - 1) / scale * scale;
+    if (ns->state == NORMAL_SCREEN_KEEP) {
+        /* Nothing rendered since we left the normal screen */
+        if (!normal_screen_frame_unchanged(term, &ns->last))
+            force_full_repaint(term, buf);
+    }
 
-    struct buffer_chain *chain = term->render.chains.render_timer;
-    struct buffer *buf = shm_get_buffer(chain, width, height);
+    else if (normal_screen_frame_unchanged(term, &ns->saved) &&
+             ns->pix != NULL &&
+             pixman_image_get_width(ns->pix) == buf->width &&
+             pixman_image_get_height(ns->pix) == buf->height)
+    {
+        pixman_image_composite32(
+            PIXMAN_OP_SRC, ns->pix, NULL, buf->pix[0],
+            0, 0, 0, 0, 0, 0, buf->width, buf->height);
 
-    wl_subsurface_set_position(
-        win->render_timer.sub,
-        margin / term->scale,
-        (term->margins.top + term->cell_height - margin) / term->scale);
+        pixman_region32_union_rect(
+            &buf->dirty, &buf->dirty, 0, 0, buf->width, buf->height);
+        damage_main_surface(term, 0, 0, buf->width, buf->height);
 
-    render_osd(
-        term,
-        &win->render_timer,
-        term->fonts[0], buf, text,
-        term->colors.table[0], 0xffu << 24 | term->colors.table[8 + 1],
-        margin, margin);
-}
+        render_margin(term, buf, 0, term->rows, true);
 
-static void frame_callback(
-    void *data, struct wl_callback *wl_callback, uint32_t callback_data);
+        /* The saved frame has the cursor at its old position */
+        const struct coord *cursor = &ns->saved.cursor;
+        if (cursor->row >= 0 && cursor->row < term->rows &&
+            cursor->col >= 0 && cursor->col < term->cols)
+        {
+            struct row *row = grid_row_in_view(term->grid, cursor->row);
+            row->cells[cursor->col].attrs.clean = 0;
+            row->dirty = true;
+        }
+    }
 
-static const struct wl_callback_listener frame_listener = {
-    .done = &frame_callback,
-};
+    else
+        force_full_repaint(term, buf);
 
-static void
-force_full_repaint(struct terminal *term, struct buffer *buf)
-{
-    tll_free(term->grid->scroll_damage);
-    render_margin(term, buf, 0, term->rows, true);
-    term_damage_view(term);
+    normal_screen_discard(ns);
 }
 
 static void
@@ -2663,7 +3508,7 @@ reapply_old_damage(struct terminal *term, struct buffer *new, struct buffer *old
      * and grid_render_scroll_reverse().
      */
 
-    if (tll_length(term->grid->scroll_damage) == 0) {
+    if (term->grid->scroll_damage.count == 0) {
         /*
          * We can only subtract current frame’s damage from the old
          * frame’s if we don’t have any scroll damage.
@@ -2688,6 +3533,15 @@ reapply_old_damage(struct terminal *term, struct buffer *new, struct buffer *old
     pixman_region32_fini(&dirty);
 }
 
+static void
+remember_cursor(struct terminal *term)
+{
+    /* Remember current cursor position, for the next frame */
+    term->render.last_cursor.row = grid_row(term->grid, term->grid->cursor.point.row);
+    term->render.last_cursor.col = term->grid->cursor.point.col;
+    term->render.last_cursor.hidden = term->hide_cursor;
+}
+
 static void
 dirty_old_cursor(struct terminal *term)
 {
@@ -2698,10 +3552,7 @@ dirty_old_cursor(struct terminal *term)
         row->dirty = true;
     }
 
-    /* Remember current cursor position, for the next frame */
-    term->render.last_cursor.row = grid_row(term->grid, term->grid->cursor.point.row);
-    term->render.last_cursor.col = term->grid->cursor.point.col;
-    term->render.last_cursor.hidden = term->hide_cursor;
+    remember_cursor(term);
 }
 
 static void
@@ -2718,26 +3569,192 @@ dirty_cursor(struct terminal *term)
     row->dirty = true;
 }
 
+/* Can the cursor be rendered on its own sub-surface? */
+static bool
+cursor_surface_usable(const struct terminal *term)
+{
+    /*
+     * Sub-surface positions are in logical coordinates; with
+     * fractional scaling, we can't align it with the grid
+     */
+    if (term->scale != (int)term->scale)
+        return false;
+
+#if defined(FOOT_IME_ENABLED) && FOOT_IME_ENABLED
+    /* The pre-edit string, and its cursor, is rendered by the grid */
+    tll_foreach(term->wl->seats, it) {
+        if (it->item.kbd_focus == term && it->item.ime.preedit.cells != NULL)
+            return false;
+    }
+#endif
+
+    return true;
+}
+
 static void
-grid_render(struct terminal *term)
+cursor_surface_unmap(struct terminal *term)
 {
-    if (term->shutdown.in_progress)
+    struct wayl_sub_surface *surf = &term->window->cursor;
+
+    if (!term->render.cursor_surface.mapped)
         return;
 
-    struct timespec start_time, start_double_buffering = {0}, stop_double_buffering = {0};
+    wl_surface_attach(surf->surface.surf, NULL, 0, 0);
+    wl_surface_commit(surf->surface.surf);
+    term->render.cursor_surface.mapped = false;
+
+    /* Work around Sway bug - unmapping a sub-surface does not damage
+     * the underlying surface */
+    quirk_sway_subsurface_unmap(term);
+}
+
+/*
+ * Renders the cursor, and the cell beneath it (block cursors only),
+ * to the cursor sub-surface. Like all sub-surface state, it is
+ * applied on the next commit of the main surface.
+ */
+static void
+render_cursor_surface(struct terminal *term)
+{
+    struct wl_window *win = term->window;
+    struct wayl_sub_surface *surf = &win->cursor;
+
+    /* Translate offset-relative row to view-relative */
+    struct coord cursor = term->grid->cursor.point;
+    cursor.row += term->grid->offset;
+    cursor.row -= term->grid->view;
+    cursor.row &= term->grid->num_rows - 1;
+
+    /* Same conditions as in draw_cursor() */
+    const bool visible =
+        !term->hide_cursor &&
+        cursor.row < term->rows &&
+        (term->cursor_blink.state == CURSOR_BLINK_ON || !term->kbd_focus);
+
+    if (!visible) {
+        cursor_surface_unmap(term);
+        return;
+    }
+
+    if (surf->surface.surf == NULL) {
+        if (!wayl_win_subsurface_new(win, surf, false)) {
+            LOG_ERR("failed to create cursor surface");
+            return;
+        }
+
+        /* Directly above the grid, below all other sub-surfaces */
+        wl_subsurface_place_above(surf->sub, win->surface.surf);
+    }
+
+    const int scale = term->scale;
+    const int x = term->margins.left + cursor.col * term->cell_width;
+    const int y = term->margins.top + cursor.row * term->cell_height;
+
+    /* Sub-surface must be positioned on a logical pixel boundary */
+    const int surf_x = x / scale * scale;
+    const int surf_y = y / scale * scale;
+
+    /* Room for double-width characters, and glyphs overflowing into
+     * the next cell */
+    const int cols = min(3, term->cols - cursor.col);
+
+    const int width =
+        (x - surf_x + cols * term->cell_width + scale - 1) / scale * scale;
+    const int height =
+        (y - surf_y + term->cell_height + scale - 1) / scale * scale;
+
+    struct buffer_chain *chain = term->render.chains.cursor;
+    struct buffer *buf = shm_get_buffer(chain, width, height);
+
+    pixman_image_fill_rectangles(
+        PIXMAN_OP_SRC, buf->pix[0], &(pixman_color_t){0}, 1,
+        &(pixman_rectangle16_t){0, 0, width, height});
+
+    struct row *row = grid_row_in_view(term->grid, cursor.row);
+    render_cell_at(
+        term, buf->pix[0], row, cursor.col, x - surf_x, y - surf_y,
+        true, true);
+
+    wl_subsurface_set_position(surf->sub, surf_x / scale, surf_y / scale);
+
+    wayl_surface_scale(win, &surf->surface, buf, scale);
+    wl_surface_attach(surf->surface.surf, buf->wl_buf, 0, 0);
+    wl_surface_damage_buffer(surf->surface.surf, 0, 0, width, height);
+
+    wl_surface_commit(surf->surface.surf);
+    term->render.cursor_surface.mapped = true;
+}
+
+/* Cursor update (blink) that doesn’t require a new grid frame */
+static void
+render_cursor_only(struct terminal *term)
+{
+    xassert(term->render.cursor_surface.active);
+
+    render_cursor_surface(term);
+    wl_surface_commit(term->window->surface.surf);
+}
+
+/*
+ * A grid frame being rendered. See grid_render_begin() and
+ * grid_render_end().
+ */
+struct grid_frame {
+    struct buffer *buf;
+    bool cursor_surface;
+    size_t dirty_rows;
+
+    struct timespec start_time;
+    struct timespec start_double_buffering;
+    struct timespec stop_double_buffering;
+};
+
+/*
+ * First half of rendering a frame: prepares the buffer, applies
+ * scroll damage, and hands the dirty rows to the render workers.
+ *
+ * When there are render workers, this returns without waiting for
+ * them. The main thread may thus prepare frames for other terminals
+ * while the rows are being rendered. Nothing may touch the
+ * terminal’s grid until grid_render_end() has been called.
+ *
+ * Returns false if no frame should be rendered.
+ */
+static bool
+grid_render_begin(struct terminal *term, struct grid_frame *frame)
+{
+    if (term->shutdown.in_progress)
+        return false;
 
-    if (term->conf->tweak.render_timer != RENDER_TIMER_NONE)
-        clock_gettime(CLOCK_MONOTONIC, &start_time);
+    *frame = (struct grid_frame){0};
+
+    struct timespec start_time, start_double_buffering = {0}, stop_double_buffering = {0};
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
 
     xassert(term->width > 0);
     xassert(term->height > 0);
 
+    normal_screen_save(term);
+
     struct buffer_chain *chain = term->render.chains.grid;
     struct buffer *buf = shm_get_buffer(chain, term->width, term->height);
 
-    /* Dirty old and current cursor cell, to ensure they’re repainted */
-    dirty_old_cursor(term);
-    dirty_cursor(term);
+    /*
+     * Dirty old and current cursor cell, to ensure they’re
+     * repainted. Not needed when the cursor is on its own
+     * sub-surface, except when switching to/from it.
+     */
+    const bool cursor_surface = cursor_surface_usable(term);
+
+    if (cursor_surface && term->render.cursor_surface.active)
+        remember_cursor(term);
+    else {
+        dirty_old_cursor(term);
+        dirty_cursor(term);
+    }
+
+    term->render.cursor_surface.active = cursor_surface;
+    term->render.refresh.cursor = false;
 
     if (term->render.last_buf == NULL ||
         term->render.last_buf->width != buf->width ||
@@ -2760,6 +3777,8 @@ grid_render(struct terminal *term)
         clock_gettime(CLOCK_MONOTONIC, &stop_double_buffering);
     }
 
+    normal_screen_restore(term, buf);
+
     if (term->render.last_buf != NULL) {
         shm_unref(term->render.last_buf);
         term->render.last_buf = NULL;
@@ -2770,30 +3789,32 @@ grid_render(struct terminal *term)
     buf->age = 0;
 
 
-    tll_foreach(term->grid->scroll_damage, it) {
-        switch (it->item.type) {
+    for (size_t i = 0; i < term->grid->scroll_damage.count; i++) {
+        const struct damage *dmg = &term->grid->scroll_damage.v[i];
+
+        switch (dmg->type) {
         case DAMAGE_SCROLL:
             if (term->grid->view == term->grid->offset)
-                grid_render_scroll(term, buf, &it->item);
+                grid_render_scroll(term, buf, dmg);
             break;
 
         case DAMAGE_SCROLL_REVERSE:
             if (term->grid->view == term->grid->offset)
-                grid_render_scroll_reverse(term, buf, &it->item);
+                grid_render_scroll_reverse(term, buf, dmg);
             break;
 
         case DAMAGE_SCROLL_IN_VIEW:
-            grid_render_scroll(term, buf, &it->item);
+            grid_render_scroll(term, buf, dmg);
             break;
 
         case DAMAGE_SCROLL_REVERSE_IN_VIEW:
-            grid_render_scroll_reverse(term, buf, &it->item);
+            grid_render_scroll_reverse(term, buf, dmg);
             break;
         }
-
-        tll_remove(term->grid->scroll_damage, it);
     }
 
+    term->grid->scroll_damage.count = 0;
+
     /*
      * Ensure selected cells have their 'selected' bit set. This is
      * normally "automatically" true - the bit is set when the
@@ -2816,13 +3837,15 @@ grid_render(struct terminal *term)
     /* Translate offset-relative row to view-relative, unless cursor
      * is hidden, then we just set it to -1 */
     struct coord cursor = {-1, -1};
-    if (!term->hide_cursor) {
+    if (!term->hide_cursor && !cursor_surface) {
         cursor = term->grid->cursor.point;
         cursor.row += term->grid->offset;
         cursor.row -= term->grid->view;
         cursor.row &= term->grid->num_rows - 1;
     }
 
+    normal_screen_frame(term, cursor);
+
     if (term->conf->tweak.overflowing_glyphs) {
         /*
          * Pre-pass to dirty cells affected by overflowing glyphs.
@@ -2893,6 +3916,9 @@ grid_render(struct terminal *term)
 
     render_sixel_images(term, buf->pix[0], &cursor);
 
+    if (term->is_searching)
+        search_matches_invalidate_dirty_rows(term);
+
     if (term->render.workers.count > 0) {
         mtx_lock(&term->render.workers.lock);
         term->render.workers.buf = buf;
@@ -2902,6 +3928,7 @@ grid_render(struct terminal *term)
         xassert(tll_length(term->render.workers.queue) == 0);
     }
 
+    size_t dirty_rows = 0;
     int first_dirty_row = -1;
     for (int r = 0; r < term->rows; r++) {
         struct row *row = grid_row_in_view(term->grid, r);
@@ -2913,8 +3940,7 @@ grid_render(struct terminal *term)
                 int width = term->width - term->margins.left - term->margins.right;
                 int height = (r - first_dirty_row) * term->cell_height;
 
-                wl_surface_damage_buffer(
-                    term->window->surface.surf, x, y, width, height);
+                damage_main_surface(term, x, y, width, height);
                 pixman_region32_union_rect(
                     &buf->dirty, &buf->dirty, 0, y, buf->width, height);
             }
@@ -2926,6 +3952,7 @@ grid_render(struct terminal *term)
             first_dirty_row = r;
 
         row->dirty = false;
+        dirty_rows++;
 
         if (term->render.workers.count > 0)
             tll_push_back(term->render.workers.queue, r);
@@ -2942,7 +3969,7 @@ grid_render(struct terminal *term)
         int width = term->width - term->margins.left - term->margins.right;
         int height = (term->rows - first_dirty_row) * term->cell_height;
 
-        wl_surface_damage_buffer(term->window->surface.surf, x, y, width, height);
+        damage_main_surface(term, x, y, width, height);
         pixman_region32_union_rect(&buf->dirty, &buf->dirty, 0, y, buf->width, height);
     }
 
@@ -2951,23 +3978,61 @@ grid_render(struct terminal *term)
         for (size_t i = 0; i < term->render.workers.count; i++)
             tll_push_back(term->render.workers.queue, -1);
         mtx_unlock(&term->render.workers.lock);
+    }
+
+    *frame = (struct grid_frame){
+        .buf = buf,
+        .cursor_surface = cursor_surface,
+        .dirty_rows = dirty_rows,
+        .start_time = start_time,
+        .start_double_buffering = start_double_buffering,
+        .stop_double_buffering = stop_double_buffering,
+    };
+
+    return true;
+}
+
+/*
+ * Second half of rendering a frame: waits for the render workers to
+ * finish, renders the sub-surfaces, and commits the frame.
+ */
+static void
+grid_render_end(struct terminal *term, const struct grid_frame *frame)
+{
+    struct buffer *buf = frame->buf;
+    const bool cursor_surface = frame->cursor_surface;
+    const struct timespec start_double_buffering = frame->start_double_buffering;
+    const struct timespec stop_double_buffering = frame->stop_double_buffering;
 
+    if (term->render.workers.count > 0) {
         for (size_t i = 0; i < term->render.workers.count; i++)
             sem_wait(&term->render.workers.done);
         term->render.workers.buf = NULL;
     }
 
+    if (cursor_surface)
+        render_cursor_surface(term);
+    else
+        cursor_surface_unmap(term);
+
     render_overlay(term);
     render_ime_preedit(term, buf);
     render_scrollback_position(term);
 
-    if (term->conf->tweak.render_timer != RENDER_TIMER_NONE) {
-        struct timespec end_time;
-        clock_gettime(CLOCK_MONOTONIC, &end_time);
+    struct timespec end_time;
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+    struct timespec render_time;
+    timespec_sub(&end_time, &frame->start_time, &render_time);
+
+    stats_frame_rendered(
+        &term->stats,
+        (uint64_t)render_time.tv_sec * 1000000000 + render_time.tv_nsec,
+        frame->dirty_rows);
 
-        struct timespec render_time;
-        timespec_sub(&end_time, &start_time, &render_time);
+    render_stats(term);
 
+    if (term->conf->tweak.render_timer != RENDER_TIMER_NONE) {
         struct timespec double_buffering_time;
         timespec_sub(&stop_double_buffering, &start_double_buffering, &double_buffering_time);
 
@@ -3011,6 +4076,10 @@ grid_render(struct terminal *term)
     xassert(term->window->frame_callback == NULL);
     term->window->frame_callback = wl_surface_frame(term->window->surface.surf);
     wl_callback_add_listener(term->window->frame_callback, &frame_listener, term);
+    clock_gettime(CLOCK_MONOTONIC, &term->render.frame_requested);
+
+    /* New frame, new parse budget */
+    term->flow_control.parse_ns = 0;
 
     wayl_win_scale(term->window, buf);
 
@@ -3042,14 +4111,25 @@ grid_render(struct terminal *term)
     }
 
     if (term->conf->tweak.damage_whole_window) {
+        pixman_region32_clear(&term->render.damage);
         wl_surface_damage_buffer(
             term->window->surface.surf, 0, 0, INT32_MAX, INT32_MAX);
-    }
+        term->stats.damage.sent++;
+    } else
+        damage_submit(term, term->window->surface.surf, &term->render.damage);
 
     wl_surface_attach(term->window->surface.surf, buf->wl_buf, 0, 0);
     wl_surface_commit(term->window->surface.surf);
 }
 
+static void
+grid_render(struct terminal *term)
+{
+    struct grid_frame frame;
+    if (grid_render_begin(term, &frame))
+        grid_render_end(term, &frame);
+}
+
 static void
 render_search_box(struct terminal *term)
 {
@@ -3438,7 +4518,7 @@ render_urls(struct terminal *term)
 
     /* Positioning data + label contents */
     struct {
-        const struct wl_url *url;
+        struct wl_url *url;
         char32_t *text;
         int x;
         int y;
@@ -3450,6 +4530,13 @@ render_urls(struct terminal *term)
 
     size_t render_count = 0;
 
+    const uint32_t fg = term->conf->colors.use_custom.jump_label
+        ? term->conf->colors.jump_label.fg
+        : term->colors.table[0];
+    const uint32_t bg = term->conf->colors.use_custom.jump_label
+        ? term->conf->colors.jump_label.bg
+        : term->colors.table[3];
+
     tll_foreach(win->urls, it) {
         const struct url *url = it->item.url;
         const char32_t *key = url->key;
@@ -3482,8 +4569,11 @@ render_urls(struct terminal *term)
             hide = true;
 
         if (hide) {
-            wl_surface_attach(surf, NULL, 0, 0);
-            wl_surface_commit(surf);
+            if (it->item.surf.osd.text != NULL) {
+                wl_surface_attach(surf, NULL, 0, 0);
+                wl_surface_commit(surf);
+                osd_cache_reset(&it->item.surf.osd);
+            }
             continue;
         }
 
@@ -3573,6 +4663,18 @@ render_urls(struct terminal *term)
         const int height =
             (2 * y_margin + term->cell_height + scale - 1) / scale * scale;
 
+        if (osd_cache_matches(term, &it->item.surf, term->fonts[0], label,
+                              fg, 0xffu << 24 | bg, width, height))
+        {
+            /* Label already shows this; typically the case for all
+             * labels not matching the last entered key */
+            wl_subsurface_set_position(
+                sub_surf,
+                (term->margins.left + x) / term->scale,
+                (term->margins.top + y) / term->scale);
+            continue;
+        }
+
         info[render_count].url = &it->item;
         info[render_count].text = xc32dup(label);
         info[render_count].x = x;
@@ -3584,19 +4686,15 @@ render_urls(struct terminal *term)
         render_count++;
     }
 
+    if (render_count == 0)
+        return;
+
     struct buffer_chain *chain = term->render.chains.url;
     struct buffer *bufs[render_count];
     shm_get_many(chain, render_count, widths, heights, bufs);
 
-    uint32_t fg = term->conf->colors.use_custom.jump_label
-        ? term->conf->colors.jump_label.fg
-        : term->colors.table[0];
-    uint32_t bg = term->conf->colors.use_custom.jump_label
-        ? term->conf->colors.jump_label.bg
-        : term->colors.table[3];
-
     for (size_t i = 0; i < render_count; i++) {
-        const struct wayl_sub_surface *sub_surf = &info[i].url->surf;
+        struct wayl_sub_surface *sub_surf = &info[i].url->surf;
 
         const char32_t *label = info[i].text;
         const int x = info[i].x;
@@ -3631,6 +4729,7 @@ render_update_title(struct terminal *term)
         title = copy;
     }
 
+    wayl_flush_unblock(term->wl);
     xdg_toplevel_set_title(term->window->xdg_toplevel, title);
     free(copy);
 }
@@ -3644,6 +4743,34 @@ frame_callback(void *data, struct wl_callback *wl_callback, uint32_t callback_da
     wl_callback_destroy(wl_callback);
     term->window->frame_callback = NULL;
 
+    /* Previous frame has been presented */
+    if (unlikely(term->flow_control.paused))
+        term_flow_control_resume(term);
+
+    if (unlikely(term->render.frame_starved)) {
+        /* We’re being shown again */
+        term->render.frame_starved = false;
+        term_visibility_update(term);
+    }
+
+    if (unlikely(term->render.hidden))
+        return;
+
+    if (unlikely(term->wl->flush_blocked)) {
+        /* Let fdm_hook_refresh_pending_terminals() render it, once
+         * the Wayland socket has drained */
+        term->render.refresh.grid |= term->render.pending.grid;
+        term->render.refresh.csd |= term->render.pending.csd;
+        term->render.refresh.search |= term->render.pending.search;
+        term->render.refresh.urls |= term->render.pending.urls;
+
+        term->render.pending.grid = false;
+        term->render.pending.csd = false;
+        term->render.pending.search = false;
+        term->render.pending.urls = false;
+        return;
+    }
+
     bool grid = term->render.pending.grid;
     bool csd = term->render.pending.csd;
     bool search = term->is_searching && term->render.pending.search;
@@ -3740,7 +4867,7 @@ delayed_reflow_of_normal_grid(struct terminal *term)
     term->render.last_buf = NULL;
     term->render.last_cursor.row = NULL;
 
-    tll_free(term->normal.scroll_damage);
+    term->normal.scroll_damage.count = 0;
     sixel_reflow_grid(term, &term->normal);
 
     if (term->grid == &term->normal) {
@@ -3841,6 +4968,9 @@ maybe_resize(struct terminal *term, int width, int height, bool force)
     if (term->cell_width == 0 && term->cell_height == 0)
         return false;
 
+    /* Commits the window, CSDs etc, outside of frame rendering */
+    wayl_flush_unblock(term->wl);
+
     float scale = -1;
     if (wayl_fractional_scaling(term->wl)) {
         scale = term->window->scale;
@@ -4046,7 +5176,6 @@ maybe_resize(struct terminal *term, int width, int height, bool force)
             .saved_cursor = orig->saved_cursor,
             .rows = xcalloc(g.num_rows, sizeof(g.rows[0])),
             .cur_row = NULL,
-            .scroll_damage = tll_init(),
             .sixel_images = tll_init(),
             .kitty_kbd = orig->kitty_kbd,
         };
@@ -4062,6 +5191,7 @@ maybe_resize(struct terminal *term, int width, int height, bool force)
             memcpy(g.rows[i]->cells,
                    orig->rows[j]->cells,
                    g.num_cols * sizeof(g.rows[i]->cells[0]));
+            g.rows[i]->used = min(orig->rows[j]->used, g.num_cols);
         }
 
         term->normal = g;
@@ -4201,11 +5331,18 @@ damage_view:
             term->height / term->scale + title_height + 2 * border_width);
     }
 
-    tll_free(term->normal.scroll_damage);
-    tll_free(term->alt.scroll_damage);
+    term->normal.scroll_damage.count = 0;
+    term->alt.scroll_damage.count = 0;
 
     shm_unref(term->render.last_buf);
     term->render.last_buf = NULL;
+    if (term->render.normal_screen != NULL)
+        normal_screen_discard(term->render.normal_screen);
+
+    /* Cell size, or margins, may have changed, even if the number of
+     * rows and columns (and thus the overlay’s match spans) didn’t */
+    term->render.last_overlay_buf = NULL;
+
     term_damage_view(term);
     render_refresh_csd(term);
     render_refresh_search(term);
@@ -4335,25 +5472,67 @@ xcursor_callback(void *data, struct wl_callback *wl_callback, uint32_t callback_
     }
 }
 
+/* Consider the window hidden when a frame callback is this late */
+static const time_t frame_starvation_timeout_secs = 1;
+
 static void
 fdm_hook_refresh_pending_terminals(struct fdm *fdm, void *data)
 {
     struct renderer *renderer = data;
     struct wayland *wayl = renderer->wayl;
 
+    if (unlikely(wayl->flush_blocked)) {
+        /* The compositor isn’t keeping up. Refresh flags are kept,
+         * and acted upon when the Wayland socket has drained */
+        return;
+    }
+
+    /*
+     * Frames are rendered in two passes: the first prepares each
+     * terminal’s frame, and hands its dirty rows to its render
+     * workers, without waiting for them. The second waits for the
+     * workers, and commits.
+     *
+     * This lets the rows of all terminals be rendered concurrently;
+     * the total time is that of the slowest terminal, rather than the
+     * sum of all of them.
+     */
+    struct {
+        struct terminal *term;
+        struct grid *original_grid;
+        struct grid_frame frame;
+    } frames[max(tll_length(wayl->terms), 1)];
+    size_t frame_count = 0;
+
     tll_foreach(renderer->wayl->terms, it) {
         struct terminal *term = it->item;
 
         if (unlikely(term->shutdown.in_progress || !term->window->is_configured))
             continue;
 
+        /* Refresh flags are kept, and acted upon when visible again */
+        if (unlikely(term->render.hidden))
+            continue;
+
         bool grid = term->render.refresh.grid;
         bool csd = term->render.refresh.csd;
         bool search = term->is_searching && term->render.refresh.search;
         bool urls = urls_mode_is_active(term) && term->render.refresh.urls;
 
-        if (!(grid | csd | search | urls))
+        if (!(grid | csd | search | urls)) {
+            /*
+             * Cursor blink; no need for a new frame. Deferred while
+             * the application is doing a synchronized update, since
+             * committing would show the half-updated grid.
+             */
+            if (term->render.refresh.cursor &&
+                !term->render.app_sync_updates.enabled)
+            {
+                term->render.refresh.cursor = false;
+                render_cursor_only(term);
+            }
             continue;
+        }
 
         if (term->render.app_sync_updates.enabled && !(csd | search | urls))
             continue;
@@ -4363,6 +5542,32 @@ fdm_hook_refresh_pending_terminals(struct fdm *fdm, void *data)
         term->render.refresh.search = false;
         term->render.refresh.urls = false;
 
+        if (unlikely(term->render.app_sync_updates.flush)) {
+            term->render.app_sync_updates.flush = false;
+
+            if (term->window->frame_callback != NULL) {
+                /*
+                 * The application just finished a synchronized
+                 * update. Don’t hold the (complete) frame back
+                 * waiting for the compositor; render it right away,
+                 * along with whatever the frame callback would have
+                 * rendered.
+                 */
+                wl_callback_destroy(term->window->frame_callback);
+                term->window->frame_callback = NULL;
+
+                grid |= term->render.pending.grid;
+                csd |= term->render.pending.csd;
+                search |= term->is_searching && term->render.pending.search;
+                urls |= urls_mode_is_active(term) && term->render.pending.urls;
+
+                term->render.pending.grid = false;
+                term->render.pending.csd = false;
+                term->render.pending.search = false;
+                term->render.pending.urls = false;
+            }
+        }
+
         if (term->window->frame_callback == NULL) {
             struct grid *original_grid = term->grid;
             if (urls_mode_is_active(term)) {
@@ -4379,22 +5584,51 @@ fdm_hook_refresh_pending_terminals(struct fdm *fdm, void *data)
                 render_search_box(term);
             if (urls)
                 render_urls(term);
-            if (grid | csd | search | urls)
-                grid_render(term);
-
-            tll_foreach(term->wl->seats, it) {
-                if (it->item.ime_focus == term)
-                    ime_update_cursor_rect(&it->item);
-            }
 
-            term->grid = original_grid;
+            /* Render workers use term->grid; it is restored when the
+             * frame has been completed */
+            if (grid_render_begin(term, &frames[frame_count].frame)) {
+                frames[frame_count].term = term;
+                frames[frame_count].original_grid = original_grid;
+                frame_count++;
+            } else
+                term->grid = original_grid;
         } else {
             /* Tells the frame callback to render again */
             term->render.pending.grid |= grid;
             term->render.pending.csd |= csd;
             term->render.pending.search |= search;
             term->render.pending.urls |= urls;
+            term->stats.render.deferred++;
+
+            /*
+             * Compositors not implementing the ‘suspended’ state
+             * typically stop sending frame callbacks to surfaces that
+             * aren’t visible. Treat a long overdue frame callback as
+             * the window being hidden.
+             */
+            struct timespec now, overdue;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            timespec_sub(&now, &term->render.frame_requested, &overdue);
+
+            if (overdue.tv_sec >= frame_starvation_timeout_secs) {
+                term->render.frame_starved = true;
+                term_visibility_update(term);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < frame_count; i++) {
+        struct terminal *term = frames[i].term;
+
+        grid_render_end(term, &frames[i].frame);
+
+        tll_foreach(term->wl->seats, it) {
+            if (it->item.ime_focus == term)
+                ime_update_cursor_rect(&it->item);
         }
+
+        term->grid = frames[i].original_grid;
     }
 
     tll_foreach(wayl->seats, it) {
@@ -4422,9 +5656,14 @@ render_refresh_title(struct terminal *term)
     struct timespec diff;
     timespec_sub(&now, &term->render.title.last_update, &diff);
 
-    if (diff.tv_sec == 0 && diff.tv_nsec < 8333 * 1000) {
+    /* Rate limit harder when no one’s looking (taskbars etc may still
+     * show the title) */
+    const long interval_ns = term->render.hidden
+        ? 500 * 1000000 : 8333 * 1000;
+
+    if (diff.tv_sec == 0 && diff.tv_nsec < interval_ns) {
         const struct itimerspec timeout = {
-            .it_value = {.tv_nsec = 8333 * 1000 - diff.tv_nsec},
+            .it_value = {.tv_nsec = interval_ns - diff.tv_nsec},
         };
 
         timerfd_settime(term->render.title.timer_fd, 0, &timeout, NULL);
@@ -4442,6 +5681,17 @@ render_refresh(struct terminal *term)
     term->render.refresh.grid = true;
 }
 
+void
+render_refresh_cursor(struct terminal *term)
+{
+    if (term->render.cursor_surface.active)
+        term->render.refresh.cursor = true;
+    else {
+        term_damage_cursor(term);
+        render_refresh(term);
+    }
+}
+
 void
 render_refresh_csd(struct terminal *term)
 {
@@ -4463,6 +5713,38 @@ render_refresh_urls(struct terminal *term)
         term->render.refresh.urls = true;
 }
 
+size_t
+render_release_buffers(struct terminal *term)
+{
+    size_t released = 0;
+
+    released += shm_chain_release_idle(term->render.chains.grid);
+    released += shm_chain_release_idle(term->render.chains.search);
+    released += shm_chain_release_idle(term->render.chains.scrollback_indicator);
+    released += shm_chain_release_idle(term->render.chains.render_timer);
+    released += shm_chain_release_idle(term->render.chains.stats);
+    released += shm_chain_release_idle(term->render.chains.url);
+    released += shm_chain_release_idle(term->render.chains.csd);
+    released += shm_chain_release_idle(term->render.chains.cursor);
+
+    struct normal_screen *ns = term->render.normal_screen;
+    if (ns != NULL && ns->state == NORMAL_SCREEN_SAVED) {
+        released += pixman_image_get_stride(ns->pix) *
+                    pixman_image_get_height(ns->pix);
+        normal_screen_discard(ns);
+    }
+
+    size_t overlay = shm_chain_release_idle(term->render.chains.overlay);
+    if (overlay > 0) {
+        /* Not ref:d; may have been destroyed. Forces a full redraw of
+         * the overlay next time it’s rendered */
+        term->render.last_overlay_buf = NULL;
+        released += overlay;
+    }
+
+    return released;
+}
+
 bool
 render_xcursor_set(struct seat *seat, struct terminal *term,
                    enum cursor_shape shape)
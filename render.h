@@ -15,9 +15,13 @@ bool render_resize_force(struct terminal *term, int width, int height);
 
 void render_refresh(struct terminal *term);
 void render_refresh_csd(struct terminal *term);
+void render_refresh_cursor(struct terminal *term);
 void render_refresh_search(struct terminal *term);
 void render_refresh_title(struct terminal *term);
 void render_refresh_urls(struct terminal *term);
+
+/* Releases cached (idle) SHM buffers. Returns the number of bytes released */
+size_t render_release_buffers(struct terminal *term);
 bool render_xcursor_set(
     struct seat *seat, struct terminal *term, enum cursor_shape shape);
 bool render_xcursor_is_valid(const struct seat *seat, const char *cursor);
@@ -28,6 +32,18 @@ struct render_worker_context {
 };
 int render_worker_thread(void *_ctx);
 
+/* Stops the sixel scaler thread (if started), and discards pending jobs */
+void render_sixel_scaler_destroy(struct terminal *term);
+
+/*
+ * Must be called when switching to, and from, the alternate
+ * screen. Saves the normal screen's pixels, and restores them when
+ * switching back (instead of re-rendering the whole normal screen)
+ */
+void render_alt_screen_entered(struct terminal *term);
+void render_alt_screen_exited(struct terminal *term);
+void render_normal_screen_destroy(struct terminal *term);
+
 struct csd_data {
     int x;
     int y;
@@ -75,6 +75,31 @@ class StringCapability(Capability):
         super().__init__(name, value)
 
 
+def c_string_length(s: str) -> int:
+    """Length, in bytes, of the C string literal ‘s’ (without quotes)"""
+    s = s.replace('" "', '')
+
+    length = 0
+    i = 0
+    while i < len(s):
+        if s[i] == '\\':
+            i += 1
+            if s[i] in '01234567':
+                # Octal escape; up to three digits
+                end = i + 1
+                while end < len(s) and end < i + 3 and s[end] in '01234567':
+                    end += 1
+                i = end
+            else:
+                i += 1
+            length += 1
+        else:
+            length += len(s[i].encode('utf-8'))
+            i += 1
+
+    return length
+
+
 class Fragment:
     def __init__(self, name: str, description: str):
         self._name = name
@@ -197,10 +222,35 @@ def main():
 
     terminfo = '\\0" "'.join(terminfo_parts)
 
+    # Sorted index into the blob above, allowing capabilities to be
+    # looked up with a binary search
+    index = []
+    offset = 0
+    for name, value in zip(terminfo_parts[0::2], terminfo_parts[1::2]):
+        name_offset = offset
+        offset += c_string_length(name) + 1
+        value_offset = offset
+        offset += c_string_length(value) + 1
+        index.append(f'{{{name_offset}, {value_offset}}}')
+
+    assert offset < 2**16
+
     target.write('#pragma once\n')
     target.write('\n')
+    target.write('#include <stdint.h>\n')
+    target.write('\n')
     target.write(f'static const char terminfo_capabilities[] = "{terminfo}";')
     target.write('\n')
+    target.write('\n')
+    target.write('struct foot_terminfo_entry {\n')
+    target.write('    uint16_t name;   /* Offset into terminfo_capabilities */\n')
+    target.write('    uint16_t value;  /* Offset into terminfo_capabilities */\n')
+    target.write('};\n')
+    target.write('\n')
+    target.write('static const struct foot_terminfo_entry terminfo_index[] = {\n')
+    for i in range(0, len(index), 4):
+        target.write(f'    {", ".join(index[i:i + 4])},\n')
+    target.write('};\n')
 
 
 if __name__ == '__main__':
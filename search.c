@@ -109,6 +109,7 @@ search_cancel_keep_selection(struct terminal *term)
     term->search.match_len = 0;
     term->is_searching = false;
     term->render.search_glyph_offset = 0;
+    search_matches_cache_destroy(term);
 
     /* Reset IME state */
     if (term_ime_is_enabled(term)) {
@@ -323,6 +324,25 @@ find_next(struct terminal *term, enum search_direction direction,
              backward ? match_start_col >= 0 : match_start_col < term->cols;
              backward ? match_start_col-- : match_start_col++)
         {
+            if (match_start_col >= row->used && term->search.buf[0] != U' ') {
+                /*
+                 * Empty cells can only match a space. Jump to the
+                 * last cell of the empty run (or the end point, if
+                 * it's inside the run); it's handled as usual below
+                 */
+                int last = backward ? row->used : term->cols - 1;
+
+                if (match_start_row == abs_end.row &&
+                    (backward
+                     ? abs_end.col >= last && abs_end.col <= match_start_col
+                     : abs_end.col >= match_start_col && abs_end.col <= last))
+                {
+                    last = abs_end.col;
+                }
+
+                match_start_col = last;
+            }
+
             if (matches_cell(term, &row->cells[match_start_col], 0) < 0) {
                 if (match_start_row == abs_end.row &&
                     match_start_col == abs_end.col)
@@ -513,92 +533,251 @@ search_find_next(struct terminal *term, enum search_direction direction)
 #undef ROW_DEC
 }
 
-struct search_match_iterator
-search_matches_new_iter(struct terminal *term)
+/*
+ * Cache of search matches in the current view.
+ *
+ * Each view row caches the matches that *start* on it. A row’s
+ * matches depend on the row itself, and the row(s) following it (a
+ * match, or a partial match, may span multiple rows). The entries are
+ * dropped when any of those rows are modified (see
+ * search_matches_invalidate_dirty_rows()), or when the query changes.
+ *
+ * Entries follow their rows when the view is scrolled, meaning only
+ * newly exposed, or modified, rows need to be re-scanned.
+ */
+struct match_cache_row {
+    const struct row *row;  /* Row the matches were found in; NULL if not cached */
+    struct range *matches;  /* Row numbers are relative to ‘row’ */
+    size_t count;
+    size_t size;
+};
+
+struct search_match_cache {
+    const struct grid *grid;
+    int view;
+    int rows;
+    int cols;
+
+    char32_t *query;
+    size_t query_len;
+
+    struct match_cache_row *v;  /* One per view row */
+};
+
+static void
+match_cache_row_reset(struct match_cache_row *entry)
+{
+    entry->row = NULL;
+    entry->count = 0;
+}
+
+static void
+match_cache_reset(struct search_match_cache *cache)
+{
+    for (int r = 0; r < cache->rows; r++)
+        match_cache_row_reset(&cache->v[r]);
+}
+
+void
+search_matches_cache_destroy(struct terminal *term)
 {
-    return (struct search_match_iterator){
-        .term = term,
-        .start = {0, 0},
-    };
+    struct search_match_cache *cache = term->search.match_cache;
+    if (cache == NULL)
+        return;
+
+    for (int r = 0; r < cache->rows; r++)
+        free(cache->v[r].matches);
+    free(cache->v);
+    free(cache->query);
+    free(cache);
+    term->search.match_cache = NULL;
 }
 
-struct range
-search_matches_next(struct search_match_iterator *iter)
+/* Number of rows, following a match’s first row, a match may span */
+static int
+match_row_span(const struct terminal *term)
+{
+    /* Double-width characters occupy two cells */
+    return (2 * term->search.len + term->cols - 1) / term->cols;
+}
+
+/*
+ * Returns the match cache, (re-)initialized as necessary. Entries are
+ * moved along with the view, when the view has changed.
+ */
+static struct search_match_cache *
+match_cache_get(struct terminal *term)
+{
+    struct search_match_cache *cache = term->search.match_cache;
+    const struct grid *grid = term->grid;
+
+    if (cache != NULL &&
+        (cache->grid != grid ||
+         cache->rows != term->rows ||
+         cache->cols != term->cols))
+    {
+        search_matches_cache_destroy(term);
+        cache = NULL;
+    }
+
+    if (cache == NULL) {
+        cache = xmalloc(sizeof(*cache));
+        *cache = (struct search_match_cache){
+            .grid = grid,
+            .view = grid->view,
+            .rows = term->rows,
+            .cols = term->cols,
+            .v = xcalloc(term->rows, sizeof(cache->v[0])),
+        };
+        term->search.match_cache = cache;
+    }
+
+    if (cache->query_len != term->search.len ||
+        (cache->query_len > 0 &&
+         memcmp(cache->query, term->search.buf,
+                cache->query_len * sizeof(cache->query[0])) != 0))
+    {
+        free(cache->query);
+        cache->query = xmalloc((term->search.len + 1) * sizeof(cache->query[0]));
+        memcpy(cache->query, term->search.buf,
+               term->search.len * sizeof(cache->query[0]));
+        cache->query_len = term->search.len;
+        match_cache_reset(cache);
+    }
+
+    if (cache->view != grid->view) {
+        const int mask = grid->num_rows - 1;
+        const int forward = (grid->view - cache->view + grid->num_rows) & mask;
+        const int backward = (cache->view - grid->view + grid->num_rows) & mask;
+        const int rows = cache->rows;
+
+        /* Rotate entries, to keep the allocations of those scrolled out */
+        struct match_cache_row old[rows];
+        memcpy(old, cache->v, rows * sizeof(old[0]));
+
+        if (forward < rows) {
+            for (int r = 0; r < rows; r++)
+                cache->v[r] = old[(r + forward) % rows];
+            for (int r = rows - forward; r < rows; r++)
+                match_cache_row_reset(&cache->v[r]);
+        } else if (backward < rows) {
+            for (int r = 0; r < rows; r++)
+                cache->v[r] = old[(r - backward + rows) % rows];
+            for (int r = 0; r < backward; r++)
+                match_cache_row_reset(&cache->v[r]);
+        } else
+            match_cache_reset(cache);
+
+        cache->view = grid->view;
+    }
+
+    return cache;
+}
+
+void
+search_matches_invalidate_dirty_rows(struct terminal *term)
+{
+    if (term->search.match_cache == NULL)
+        return;
+
+    struct search_match_cache *cache = match_cache_get(term);
+    const int span = match_row_span(term);
+
+    for (int r = 0; r < term->rows; r++) {
+        const struct row *row = grid_row_in_view(term->grid, r);
+        if (!row->dirty)
+            continue;
+
+        /* Matches starting on earlier rows may extend into this row */
+        for (int i = max(0, r - span); i <= r; i++)
+            match_cache_row_reset(&cache->v[i]);
+    }
+}
+
+static void
+match_cache_row_scan(struct terminal *term, struct match_cache_row *entry,
+                     int abs_row)
 {
-    struct terminal *term = iter->term;
     struct grid *grid = term->grid;
 
-    if (term->search.match_len == 0)
-        goto no_match;
+    match_cache_row_reset(entry);
+    entry->row = grid->rows[abs_row];
 
-    if (iter->start.row >= term->rows)
-        goto no_match;
+    for (int col = 0; col < term->cols;) {
+        struct range match;
+        if (!find_next(term, SEARCH_FORWARD,
+                       (struct coord){col, abs_row},
+                       (struct coord){term->cols - 1, abs_row},
+                       &match))
+        {
+            break;
+        }
 
-    xassert(iter->start.row >= 0);
-    xassert(iter->start.row < term->rows);
-    xassert(iter->start.col >= 0);
-    xassert(iter->start.col < term->cols);
+        match.start.row = 0;
+        match.end.row = (match.end.row - abs_row + grid->num_rows) &
+                        (grid->num_rows - 1);
 
-    struct coord abs_start = iter->start;
-    abs_start.row = grid_row_absolute_in_view(grid, abs_start.row);
+        if (entry->count >= entry->size) {
+            entry->size = entry->size == 0 ? 4 : entry->size * 2;
+            entry->matches = xrealloc(
+                entry->matches, entry->size * sizeof(entry->matches[0]));
+        }
 
-    struct coord abs_end = {
-        term->cols - 1,
-        grid_row_absolute_in_view(grid, term->rows - 1)};
+        entry->matches[entry->count++] = match;
+        col = match.start.col + 1;
+    }
+}
 
-    struct range match;
-    bool found = find_next(term, SEARCH_FORWARD, abs_start, abs_end, &match);
-    if (!found)
-        goto no_match;
-
-    LOG_DBG("match at (absolute coordinates) %dx%d-%dx%d",
-            match.start.row, match.start.col,
-            match.end.row, match.end.col);
-
-    /* Convert absolute row numbers back to view relative */
-    match.start.row = match.start.row - grid->view + grid->num_rows;
-    match.start.row &= grid->num_rows - 1;
-    match.end.row = match.end.row - grid->view + grid->num_rows;
-    match.end.row &= grid->num_rows - 1;
-
-    LOG_DBG("match at (view-local coordinates) %dx%d-%dx%d, view=%d",
-            match.start.row, match.start.col,
-            match.end.row, match.end.col, grid->view);
-
-    xassert(match.start.row >= 0);
-    xassert(match.start.row < term->rows);
-    xassert(match.end.row >= 0);
-    xassert(match.end.row < term->rows);
-
-    /* Assert match end comes *after* the match start */
-    xassert(match.end.row > match.start.row ||
-            (match.end.row == match.start.row &&
-             match.end.col >= match.start.col));
-
-    /* Assert the match starts at, or after, the iterator position */
-    xassert(match.start.row > iter->start.row ||
-            (match.start.row == iter->start.row &&
-             match.start.col >= iter->start.col));
-
-    /* Continue at next column, next time */
-    iter->start.row = match.start.row;
-    iter->start.col = match.start.col + 1;
-
-    if (iter->start.col >= term->cols) {
-        iter->start.col = 0;
-        iter->start.row++;  /* Overflow is caught in next iteration */
+static void
+search_match_spans_add(struct search_match_spans *spans, int start, int end)
+{
+    if (spans->count >= spans->size) {
+        spans->size = spans->size == 0 ? 4 : spans->size * 2;
+        spans->v = xrealloc(spans->v, spans->size * sizeof(spans->v[0]));
     }
 
-    xassert(iter->start.row >= 0);
-    xassert(iter->start.row <= term->rows);
-    xassert(iter->start.col >= 0);
-    xassert(iter->start.col < term->cols);
-    return match;
+    spans->v[spans->count++] = (struct search_match_span){start, end};
+}
+
+void
+search_matches_in_view(struct terminal *term, struct search_match_spans *rows)
+{
+    for (int r = 0; r < term->rows; r++)
+        rows[r].count = 0;
+
+    if (term->search.match_len == 0)
+        return;
+
+    struct search_match_cache *cache = match_cache_get(term);
+    const struct grid *grid = term->grid;
 
-no_match:
-    iter->start.row = -1;
-    iter->start.col = -1;
-    return (struct range){{-1, -1}, {-1,  -1}};
+    /* Rows whose matches depend on rows outside the view are always
+     * re-scanned, since we don’t track changes to those */
+    const int last_cacheable = term->rows - 1 - match_row_span(term);
+
+    for (int r = 0; r < term->rows; r++) {
+        struct match_cache_row *entry = &cache->v[r];
+        const int abs_row = grid_row_absolute_in_view(grid, r);
+
+        if (entry->row == NULL ||
+            entry->row != grid->rows[abs_row] ||
+            r > last_cacheable)
+        {
+            match_cache_row_scan(term, entry, abs_row);
+        }
+
+        for (size_t i = 0; i < entry->count; i++) {
+            const struct range *match = &entry->matches[i];
+
+            for (int j = 0; j <= match->end.row && r + j < term->rows; j++) {
+                const int start_col = j == 0 ? match->start.col : 0;
+                const int end_col =
+                    j == match->end.row ? match->end.col : term->cols - 1;
+
+                search_match_spans_add(&rows[r + j], start_col, end_col);
+            }
+        }
+    }
 }
 
 static void
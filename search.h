@@ -18,10 +18,14 @@ void search_add_chars(struct terminal *term, const char *text, size_t len);
 
 void search_selection_cancelled(struct terminal *term);
 
-struct search_match_iterator {
-    struct terminal *term;
-    struct coord start;
-};
+/*
+ * All matches of the current query in the view, split into per-row
+ * spans. ‘rows’ must have room for ‘term->rows’ entries. Matches are
+ * cached per row, and only re-scanned when the row changes.
+ */
+void search_matches_in_view(
+    struct terminal *term, struct search_match_spans *rows);
 
-struct search_match_iterator search_matches_new_iter(struct terminal *term);
-struct range search_matches_next(struct search_match_iterator *iter);
+/* Must be called before the dirty flags of the view’s rows are reset */
+void search_matches_invalidate_dirty_rows(struct terminal *term);
+void search_matches_cache_destroy(struct terminal *term);
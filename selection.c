@@ -1480,7 +1480,7 @@ selection_clipboard_unset(struct seat *seat)
     clipboard->data_source = NULL;
     clipboard->serial = 0;
 
-    free(clipboard->text);
+    selection_text_unref(clipboard->text);
     clipboard->text = NULL;
 }
 
@@ -1500,7 +1500,7 @@ selection_primary_unset(struct seat *seat)
     primary->data_source = NULL;
     primary->serial = 0;
 
-    free(primary->text);
+    selection_text_unref(primary->text);
     primary->text = NULL;
 }
 
@@ -1613,9 +1613,41 @@ target(void *data, struct wl_data_source *wl_data_source, const char *mime_type)
     LOG_DBG("TARGET: mime-type=%s", mime_type);
 }
 
+struct selection_text *
+selection_text_new(char *data, size_t len)
+{
+    struct selection_text *text = xmalloc(sizeof(*text));
+    *text = (struct selection_text){
+        .data = data,
+        .len = len,
+        .ref_count = 1,
+    };
+    return text;
+}
+
+struct selection_text *
+selection_text_ref(struct selection_text *text)
+{
+    text->ref_count++;
+    return text;
+}
+
+void
+selection_text_unref(struct selection_text *text)
+{
+    if (text == NULL)
+        return;
+
+    xassert(text->ref_count > 0);
+    if (--text->ref_count > 0)
+        return;
+
+    free(text->data);
+    free(text);
+}
+
 struct clipboard_send {
-    char *data;
-    size_t len;
+    struct selection_text *text;
     size_t idx;
 };
 
@@ -1627,7 +1659,7 @@ fdm_send(struct fdm *fdm, int fd, int events, void *data)
     if (events & EPOLLHUP)
         goto done;
 
-    switch (async_write(fd, ctx->data, ctx->len, &ctx->idx)) {
+    switch (async_write(fd, ctx->text->data, ctx->text->len, &ctx->idx)) {
     case ASYNC_WRITE_REMAIN:
         return true;
 
@@ -1637,19 +1669,20 @@ fdm_send(struct fdm *fdm, int fd, int events, void *data)
     case ASYNC_WRITE_ERR:
         LOG_ERRNO(
             "failed to asynchronously write %zu of selection data to FD=%d",
-            ctx->len - ctx->idx, fd);
+            ctx->text->len - ctx->idx, fd);
         break;
     }
 
 done:
     fdm_del(fdm, fd);
-    free(ctx->data);
+    selection_text_unref(ctx->text);
     free(ctx);
     return true;
 }
 
 static void
-send_clipboard_or_primary(struct seat *seat, int fd, const char *selection,
+send_clipboard_or_primary(struct seat *seat, int fd,
+                          struct selection_text *selection,
                           const char *source_name)
 {
     /* Make it NONBLOCK:ing right away - we don't want to block if the
@@ -1662,22 +1695,22 @@ send_clipboard_or_primary(struct seat *seat, int fd, const char *selection,
         return;
     }
 
-    size_t len = strlen(selection);
+    const size_t len = selection->len;
     size_t async_idx = 0;
 
-    switch (async_write(fd, selection, len, &async_idx)) {
+    switch (async_write(fd, selection->data, len, &async_idx)) {
     case ASYNC_WRITE_REMAIN: {
+        /* Keep a reference, instead of copying the remaining data */
         struct clipboard_send *ctx = xmalloc(sizeof(*ctx));
         *ctx = (struct clipboard_send) {
-            .data = xstrdup(&selection[async_idx]),
-            .len = len - async_idx,
-            .idx = 0,
+            .text = selection_text_ref(selection),
+            .idx = async_idx,
         };
 
         if (fdm_add(seat->wayl->fdm, fd, EPOLLOUT, &fdm_send, ctx))
             return;
 
-        free(ctx->data);
+        selection_text_unref(ctx->text);
         free(ctx);
         break;
     }
@@ -1716,7 +1749,7 @@ cancelled(void *data, struct wl_data_source *wl_data_source)
     clipboard->data_source = NULL;
     clipboard->serial = 0;
 
-    free(clipboard->text);
+    selection_text_unref(clipboard->text);
     clipboard->text = NULL;
 }
 
@@ -1771,7 +1804,7 @@ primary_cancelled(void *data,
     primary->data_source = NULL;
     primary->serial = 0;
 
-    free(primary->text);
+    selection_text_unref(primary->text);
     primary->text = NULL;
 }
 
@@ -1781,9 +1814,11 @@ static const struct zwp_primary_selection_source_v1_listener primary_selection_s
 };
 
 bool
-text_to_clipboard(struct seat *seat, struct terminal *term, char *text, uint32_t serial)
+shared_text_to_clipboard(struct seat *seat, struct terminal *term,
+                         struct selection_text *text, uint32_t serial)
 {
     xassert(serial != 0);
+    wayl_flush_unblock(term->wl);
 
     struct wl_clipboard *clipboard = &seat->clipboard;
 
@@ -1792,7 +1827,7 @@ text_to_clipboard(struct seat *seat, struct terminal *term, char *text, uint32_t
         xassert(clipboard->serial != 0);
         wl_data_device_set_selection(seat->data_device, NULL, clipboard->serial);
         wl_data_source_destroy(clipboard->data_source);
-        free(clipboard->text);
+        selection_text_unref(clipboard->text);
 
         clipboard->data_source = NULL;
         clipboard->serial = 0;
@@ -1807,7 +1842,7 @@ text_to_clipboard(struct seat *seat, struct terminal *term, char *text, uint32_t
         return false;
     }
 
-    clipboard->text = text;
+    clipboard->text = selection_text_ref(text);
 
     /* Configure source */
     wl_data_source_offer(clipboard->data_source, mime_type_map[DATA_OFFER_MIME_TEXT_UTF8]);
@@ -1824,6 +1859,19 @@ text_to_clipboard(struct seat *seat, struct terminal *term, char *text, uint32_t
     return true;
 }
 
+bool
+text_to_clipboard(struct seat *seat, struct terminal *term, char *text, uint32_t serial)
+{
+    struct selection_text *shared = selection_text_new(text, strlen(text));
+    const bool ret = shared_text_to_clipboard(seat, term, shared, serial);
+
+    if (ret)
+        selection_text_unref(shared);
+    else
+        free(shared);  /* Caller retains ownership of ‘text’ */
+    return ret;
+}
+
 void
 selection_to_clipboard(struct seat *seat, struct terminal *term, uint32_t serial)
 {
@@ -2187,6 +2235,7 @@ text_from_clipboard(struct seat *seat, struct terminal *term,
     int write_fd = fds[1];
 
     /* Give write-end of pipe to other client */
+    wayl_flush_unblock(term->wl);
     wl_data_offer_receive(
         clipboard->data_offer, mime_type_map[clipboard->mime_type], write_fd);
 
@@ -2240,12 +2289,14 @@ selection_from_clipboard(struct seat *seat, struct terminal *term, uint32_t seri
 }
 
 bool
-text_to_primary(struct seat *seat, struct terminal *term, char *text, uint32_t serial)
+shared_text_to_primary(struct seat *seat, struct terminal *term,
+                       struct selection_text *text, uint32_t serial)
 {
     if (term->wl->primary_selection_device_manager == NULL)
         return false;
 
     xassert(serial != 0);
+    wayl_flush_unblock(term->wl);
 
     struct wl_primary *primary = &seat->primary;
 
@@ -2257,7 +2308,7 @@ text_to_primary(struct seat *seat, struct terminal *term, char *text, uint32_t s
         zwp_primary_selection_device_v1_set_selection(
             seat->primary_selection_device, NULL, primary->serial);
         zwp_primary_selection_source_v1_destroy(primary->data_source);
-        free(primary->text);
+        selection_text_unref(primary->text);
 
         primary->data_source = NULL;
         primary->serial = 0;
@@ -2273,8 +2324,7 @@ text_to_primary(struct seat *seat, struct terminal *term, char *text, uint32_t s
         return false;
     }
 
-    /* Get selection as a string */
-    primary->text = text;
+    primary->text = selection_text_ref(text);
 
     /* Configure source */
     zwp_primary_selection_source_v1_offer(primary->data_source, mime_type_map[DATA_OFFER_MIME_TEXT_UTF8]);
@@ -2291,6 +2341,19 @@ text_to_primary(struct seat *seat, struct terminal *term, char *text, uint32_t s
     return true;
 }
 
+bool
+text_to_primary(struct seat *seat, struct terminal *term, char *text, uint32_t serial)
+{
+    struct selection_text *shared = selection_text_new(text, strlen(text));
+    const bool ret = shared_text_to_primary(seat, term, shared, serial);
+
+    if (ret)
+        selection_text_unref(shared);
+    else
+        free(shared);  /* Caller retains ownership of ‘text’ */
+    return ret;
+}
+
 void
 selection_to_primary(struct seat *seat, struct terminal *term, uint32_t serial)
 {
@@ -2337,6 +2400,7 @@ text_from_primary(
     int write_fd = fds[1];
 
     /* Give write-end of pipe to other client */
+    wayl_flush_unblock(term->wl);
     zwp_primary_selection_offer_v1_receive(
         primary->data_offer, mime_type_map[primary->mime_type], write_fd);
 
@@ -2642,6 +2706,7 @@ drop(void *data, struct wl_data_device *wl_data_device)
     LOG_DBG("DnD drop: mime-type=%s", mime_type_map[clipboard->mime_type]);
 
     /* Give write-end of pipe to other client */
+    wayl_flush_unblock(term->wl);
     wl_data_offer_receive(
         clipboard->data_offer, mime_type_map[clipboard->mime_type], write_fd);
 
@@ -42,12 +42,29 @@ void selection_to_primary(
     struct seat *seat, struct terminal *term, uint32_t serial);
 void selection_from_primary(struct seat *seat, struct terminal *term);
 
+/*
+ * Reference counted selection data. selection_text_new() takes
+ * ownership of ‘data’, which is free:d when the last reference is
+ * dropped.
+ */
+struct selection_text *selection_text_new(char *data, size_t len);
+struct selection_text *selection_text_ref(struct selection_text *text);
+void selection_text_unref(struct selection_text *text);
+
 /* Copy text *to* primary/clipboard */
 bool text_to_clipboard(
     struct seat *seat, struct terminal *term, char *text, uint32_t serial);
 bool text_to_primary(
     struct seat *seat, struct terminal *term, char *text, uint32_t serial);
 
+/* Like above, but adds a reference to ‘text’ instead of taking ownership */
+bool shared_text_to_clipboard(
+    struct seat *seat, struct terminal *term, struct selection_text *text,
+    uint32_t serial);
+bool shared_text_to_primary(
+    struct seat *seat, struct terminal *term, struct selection_text *text,
+    uint32_t serial);
+
 /*
  * Copy text *from* primary/clipboard
  *
@@ -4,10 +4,12 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
 
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/epoll.h>
+#include <sys/timerfd.h>
 
 #include <sys/un.h>
 
@@ -17,8 +19,10 @@
 #define LOG_ENABLE_DBG 0
 #include "log.h"
 
+#include "async.h"
 #include "client-protocol.h"
 #include "shm.h"
+#include "stats.h"
 #include "terminal.h"
 #include "util.h"
 #include "wayland.h"
@@ -50,6 +54,16 @@ struct client {
         size_t idx;
     } buffer;
 
+    bool control;  /* Client sent a control request, not a setup packet */
+
+    /* Control reply, when it couldn't be sent in one go */
+    struct {
+        uint8_t *data;
+        size_t len;
+        size_t idx;
+        int timer_fd;  /* Drops the client if it doesn't read the reply */
+    } reply;
+
     struct terminal_instance *instance;
 };
 static void client_destroy(struct client *client);
@@ -79,6 +93,9 @@ client_destroy(struct client *client)
         fdm_del(client->server->fdm, client->fd);
     }
 
+    if (client->reply.timer_fd >= 0)
+        fdm_del(client->server->fdm, client->reply.timer_fd);
+
     tll_foreach(client->server->clients, it) {
         if (it->item == client) {
             tll_remove(client->server->clients, it);
@@ -87,6 +104,7 @@ client_destroy(struct client *client)
     }
 
     free(client->buffer.data);
+    free(client->reply.data);
     free(client);
 }
 
@@ -100,6 +118,193 @@ client_send_exit_code(struct client *client, int exit_code)
         LOG_ERRNO("failed to write slave exit code to client");
 }
 
+/* Don’t let a control client that isn’t reading its reply linger */
+static const time_t reply_timeout_secs = 5;
+
+static bool
+fdm_client_reply(struct fdm *fdm, int fd, int events, void *data)
+{
+    struct client *client = data;
+
+    if (events & EPOLLHUP)
+        goto done;
+
+    switch (async_write(
+                fd, client->reply.data, client->reply.len, &client->reply.idx))
+    {
+    case ASYNC_WRITE_REMAIN:
+        return true;
+
+    case ASYNC_WRITE_DONE:
+        break;
+
+    case ASYNC_WRITE_ERR:
+        LOG_ERRNO("client FD=%d: failed to send control reply", fd);
+        break;
+    }
+
+done:
+    client_destroy(client);
+    return true;
+}
+
+static bool
+fdm_client_reply_timeout(struct fdm *fdm, int fd, int events, void *data)
+{
+    struct client *client = data;
+
+    LOG_WARN("client FD=%d: timed out sending control reply (%zu of %zu bytes)",
+             client->fd, client->reply.idx, client->reply.len);
+
+    client_destroy(client);
+    return true;
+}
+
+/*
+ * Sends the reply without blocking. Returns true if the client now
+ * belongs to the FDM handlers; it is destroyed once the rest of the
+ * reply has been sent, or when it times out.
+ */
+static bool
+client_send_reply(struct client *client, const void *data, size_t len)
+{
+    struct fdm *fdm = client->server->fdm;
+    const uint32_t reply_len = len;
+
+    client->reply.len = sizeof(reply_len) + len;
+    client->reply.data = xmalloc(client->reply.len);
+    client->reply.idx = 0;
+    memcpy(client->reply.data, &reply_len, sizeof(reply_len));
+    memcpy(&client->reply.data[sizeof(reply_len)], data, len);
+
+    switch (async_write(
+                client->fd, client->reply.data, client->reply.len,
+                &client->reply.idx))
+    {
+    case ASYNC_WRITE_DONE:
+        return false;
+
+    case ASYNC_WRITE_ERR:
+        LOG_ERRNO("client FD=%d: failed to send control reply", client->fd);
+        return false;
+
+    case ASYNC_WRITE_REMAIN:
+        break;
+    }
+
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (timer_fd < 0) {
+        LOG_ERRNO("client FD=%d: failed to create reply timer", client->fd);
+        return false;
+    }
+
+    const struct itimerspec timeout = {.it_value = {.tv_sec = reply_timeout_secs}};
+    if (timerfd_settime(timer_fd, 0, &timeout, NULL) < 0) {
+        LOG_ERRNO("client FD=%d: failed to arm reply timer", client->fd);
+        close(timer_fd);
+        return false;
+    }
+
+    if (!fdm_add(fdm, timer_fd, EPOLLIN, &fdm_client_reply_timeout, client)) {
+        close(timer_fd);
+        return false;
+    }
+
+    client->reply.timer_fd = timer_fd;
+
+    /* Replace the (setup packet) reader with the reply writer */
+    if (!fdm_del_no_close(fdm, client->fd) ||
+        !fdm_add(fdm, client->fd, EPOLLOUT, &fdm_client_reply, client))
+    {
+        /* Client FD is no longer registered */
+        close(client->fd);
+        client->fd = -1;
+        client_destroy(client);
+        return true;
+    }
+
+    return true;
+}
+
+/* Returns true if the reply is still being sent */
+static bool
+client_handle_control(struct client *client)
+{
+    struct server *server = client->server;
+
+    struct client_control ctrl;
+    if (client->buffer.idx < sizeof(ctrl)) {
+        LOG_ERR("client FD=%d: control request too short", client->fd);
+        return false;
+    }
+
+    memcpy(&ctrl, client->buffer.data, sizeof(ctrl));
+
+    if (ctrl.version != CLIENT_CONTROL_VERSION) {
+        LOG_ERR("client FD=%d: unsupported control protocol version %hu "
+                "(expected %d)", client->fd, ctrl.version,
+                CLIENT_CONTROL_VERSION);
+        return false;
+    }
+
+    char *json = NULL;
+
+    switch (ctrl.command) {
+    case CLIENT_CONTROL_STATS:
+        break;
+
+    case CLIENT_CONTROL_LIST:
+        json = stats_terminal_list_to_json(server->wayl);
+        break;
+
+    case CLIENT_CONTROL_TRIM:
+    case CLIENT_CONTROL_COMPACT:
+    case CLIENT_CONTROL_DROP_CACHES:
+        tll_foreach(server->wayl->terms, it) {
+            struct terminal *term = it->item;
+
+            if (ctrl.terminal_id != 0 && term->id != ctrl.terminal_id)
+                continue;
+
+            switch (ctrl.command) {
+            case CLIENT_CONTROL_TRIM: {
+                const int keep = min(ctrl.arg, (uint32_t)INT_MAX);
+                const size_t rows = term_scrollback_trim(term, keep);
+                LOG_INFO("terminal %u: trimmed %zu scrollback rows",
+                         term->id, rows);
+                break;
+            }
+
+            case CLIENT_CONTROL_COMPACT: {
+                const size_t rows = term_compact(term);
+                LOG_INFO("terminal %u: compacted %zu rows", term->id, rows);
+                break;
+            }
+
+            case CLIENT_CONTROL_DROP_CACHES: {
+                const size_t bytes = term_drop_caches(term);
+                LOG_INFO("terminal %u: dropped %zu bytes of scaled sixels",
+                         term->id, bytes);
+                break;
+            }
+            }
+        }
+        break;
+
+    default:
+        LOG_ERR("client FD=%d: unknown control command %hu",
+                client->fd, ctrl.command);
+        return false;
+    }
+
+    if (json == NULL)
+        json = stats_terminals_to_json(server->wayl, ctrl.terminal_id);
+
+    const bool pending = client_send_reply(client, json, strlen(json));
+    free(json);
+    return pending;
+}
+
 static void
 instance_destroy(struct terminal_instance *instance, int exit_code)
 {
@@ -178,6 +383,11 @@ fdm_client(struct fdm *fdm, int fd, int events, void *data)
             goto shutdown;
         }
 
+        if (total_len & CLIENT_CONTROL_REQUEST) {
+            client->control = true;
+            total_len &= ~CLIENT_CONTROL_REQUEST;
+        }
+
         const uint32_t max_size = 128 * 1024;
         if (total_len > max_size) {
             LOG_ERR("client wants to send too large setup packet (%u > %u)",
@@ -212,6 +422,12 @@ fdm_client(struct fdm *fdm, int fd, int events, void *data)
         return true;
     }
 
+    if (client->control) {
+        if (client_handle_control(client))
+            return true;
+        goto shutdown;
+    }
+
     /* All initialization data received - time to instantiate a terminal! */
 
     xassert(client->instance == NULL);
@@ -398,6 +614,7 @@ fdm_server(struct fdm *fdm, int fd, int events, void *data)
     *client = (struct client) {
         .server = server,
         .fd = client_fd,
+        .reply = {.timer_fd = -1},
     };
 
     if (!fdm_add(server->fdm, client_fd, EPOLLIN, &fdm_client, client)) {
@@ -87,6 +87,7 @@ struct buffer_chain {
     struct wl_shm *shm;
     size_t pix_instances;
     bool scrollable;
+    struct buffer_chain_stats stats;
 };
 
 static tll(struct buffer_private *) deferred;
@@ -521,6 +522,7 @@ shm_get_many(struct buffer_chain *chain, size_t count,
              struct buffer *bufs[static count])
 {
     get_new_buffers(chain, count, widths, heights, bufs, true);
+    chain->stats.allocated += count;
 }
 
 struct buffer *
@@ -581,11 +583,13 @@ shm_get_buffer(struct buffer_chain *chain, int width, int height)
         cached->busy = true;
         pixman_region32_clear(&cached->public.dirty);
         xassert(cached->public.pix_instances == chain->pix_instances);
+        chain->stats.reused++;
         return &cached->public;
     }
 
     struct buffer *ret;
     get_new_buffers(chain, 1, &width, &height, &ret, false);
+    chain->stats.allocated++;
     return ret;
 }
 
@@ -900,6 +904,28 @@ shm_purge(struct buffer_chain *chain)
     }
 }
 
+size_t
+shm_chain_release_idle(struct buffer_chain *chain)
+{
+    size_t released = 0;
+
+    tll_foreach(chain->bufs, it) {
+        struct buffer_private *buf = it->item;
+
+        if (buf->busy || buf->ref_count > 1)
+            continue;
+
+        LOG_DBG("chain: %p: releasing idle buffer %p",
+                (void *)chain, (void *)buf);
+
+        released += buf->size;
+        if (buffer_unref_no_remove_from_chain(buf))
+            tll_remove(chain->bufs, it);
+    }
+
+    return released;
+}
+
 void
 shm_addref(struct buffer *_buf)
 {
@@ -939,6 +965,12 @@ shm_chain_new(struct wl_shm *shm, bool scrollable, size_t pix_instances)
     return chain;
 }
 
+const struct buffer_chain_stats *
+shm_chain_stats(const struct buffer_chain *chain)
+{
+    return &chain->stats;
+}
+
 void
 shm_chain_free(struct buffer_chain *chain)
 {
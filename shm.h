@@ -2,6 +2,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 
 #include <pixman.h>
@@ -35,6 +36,13 @@ struct buffer_chain *shm_chain_new(
     struct wl_shm *shm, bool scrollable, size_t pix_instances);
 void shm_chain_free(struct buffer_chain *chain);
 
+struct buffer_chain_stats {
+    uint64_t reused;     /* shm_get_buffer() calls served from the cache */
+    uint64_t allocated;  /* Newly allocated buffers */
+};
+const struct buffer_chain_stats *shm_chain_stats(
+    const struct buffer_chain *chain);
+
 /*
  * Returns a single buffer.
  *
@@ -75,3 +83,10 @@ void shm_addref(struct buffer *buf);
 void shm_unref(struct buffer *buf);
 
 void shm_purge(struct buffer_chain *chain);
+
+/*
+ * Destroys all cached buffers, i.e. buffers that are neither owned
+ * by the compositor, nor referenced by anyone but the chain
+ * itself. Returns the number of bytes released.
+ */
+size_t shm_chain_release_idle(struct buffer_chain *chain);
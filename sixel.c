@@ -15,6 +15,7 @@
 #include "xsnprintf.h"
 
 static size_t count;
+static uint64_t next_image_id;
 
 static void sixel_put_generic(struct terminal *term, uint8_t c);
 static void sixel_put_ar_11(struct terminal *term, uint8_t c);
@@ -125,7 +126,7 @@ sixel_init(struct terminal *term, int p1, int p2, int p3)
     return pan == 1 && pad == 1 ? &sixel_put_ar_11 : &sixel_put_generic;
 }
 
-static void
+void
 sixel_invalidate_cache(struct sixel *sixel)
 {
     if (sixel->scaled.pix != NULL)
@@ -136,6 +137,7 @@ sixel_invalidate_cache(struct sixel *sixel)
     sixel->scaled.data = NULL;
     sixel->scaled.width = -1;
     sixel->scaled.height = -1;
+    sixel->scaled.preview = false;
 
     sixel->pix = NULL;
     sixel->width = -1;
@@ -164,6 +166,72 @@ sixel_destroy_all(struct terminal *term)
         sixel_destroy(&it->item);
     tll_free(term->normal.sixel_images);
     tll_free(term->alt.sixel_images);
+    sixel_index_invalidate(&term->normal);
+    sixel_index_invalidate(&term->alt);
+}
+
+void
+sixel_index_rebuild(struct grid *grid)
+{
+    const size_t words = (grid->num_rows + 63) / 64;
+
+    if (grid->sixel_index.num_rows != grid->num_rows) {
+        free(grid->sixel_index.rows);
+        grid->sixel_index.rows = xcalloc(words, sizeof(grid->sixel_index.rows[0]));
+        grid->sixel_index.num_rows = grid->num_rows;
+    } else
+        memset(grid->sixel_index.rows, 0, words * sizeof(grid->sixel_index.rows[0]));
+
+    tll_foreach(grid->sixel_images, it) {
+        const struct sixel *six = &it->item;
+
+        for (int r = 0; r < six->rows; r++) {
+            const int abs_row = (six->pos.row + r) & (grid->num_rows - 1);
+            grid->sixel_index.rows[abs_row / 64] |= 1ull << (abs_row % 64);
+        }
+    }
+
+    LOG_DBG("rebuilt sixel row index: %zu images", tll_length(grid->sixel_images));
+    grid->sixel_index.valid = true;
+}
+
+UNITTEST
+{
+    struct grid grid = {
+        .num_rows = 128,
+        .offset = 60,
+        .sixel_images = tll_init(),
+    };
+
+    xassert(!sixel_row_has_images(&grid, 0));
+
+    /* Crosses a bitmap word boundary (rows 62-65) */
+    tll_push_back(grid.sixel_images, ((struct sixel){.pos = {.row = 62}, .rows = 4}));
+    tll_push_back(grid.sixel_images, ((struct sixel){.pos = {.row = 127}, .rows = 1}));
+    sixel_index_invalidate(&grid);
+
+    xassert(!sixel_row_has_images(&grid, 1));
+    xassert(sixel_row_has_images(&grid, 2));
+    xassert(sixel_row_has_images(&grid, 5));
+    xassert(!sixel_row_has_images(&grid, 6));
+    xassert(sixel_abs_row_has_images(&grid, 127));
+    xassert(!sixel_abs_row_has_images(&grid, 0));
+    xassert(grid.sixel_index.valid);
+
+    tll_pop_front(grid.sixel_images);
+    sixel_index_invalidate(&grid);
+
+    xassert(!sixel_row_has_images(&grid, 2));
+    xassert(sixel_abs_row_has_images(&grid, 127));
+
+    /* Index is re-allocated when the grid is resized */
+    grid.num_rows = 256;
+    xassert(sixel_abs_row_has_images(&grid, 127));
+    xassert(!sixel_abs_row_has_images(&grid, 255));
+    xassert(grid.sixel_index.num_rows == 256);
+
+    tll_free(grid.sixel_images);
+    free(grid.sixel_index.rows);
 }
 
 static void
@@ -343,6 +411,8 @@ sixel_insert(struct terminal *term, struct sixel sixel)
     tll_push_back(term->grid->sixel_images, sixel);
 
 out:
+    sixel_index_invalidate(term->grid);
+
 #if defined(LOG_ENABLE_DBG) && LOG_ENABLE_DBG
     LOG_DBG("sixel list after insertion:");
     tll_foreach(term->grid->sixel_images, it) {
@@ -366,6 +436,7 @@ sixel_scroll_up(struct terminal *term, int rows)
         if (six_start < rows) {
             sixel_erase(term, six);
             tll_remove(term->grid->sixel_images, it);
+            sixel_index_invalidate(term->grid);
         } else {
             /*
              * Unfortunately, we cannot break here.
@@ -399,6 +470,7 @@ sixel_scroll_down(struct terminal *term, int rows)
         if (six_end >= term->grid->num_rows - rows) {
             sixel_erase(term, six);
             tll_remove(term->grid->sixel_images, it);
+            sixel_index_invalidate(term->grid);
         } else
             break;
     }
@@ -674,6 +746,7 @@ sixel_overwrite(struct terminal *term, struct sixel *six,
             .cols = (new_width + six->cell_width - 1) / six->cell_width,
             .rows = (new_height + six->cell_height - 1) / six->cell_height,
             .opaque = six->opaque,
+            .id = ++next_image_id,
             .cell_width = six->cell_width,
             .cell_height = six->cell_height,
             .original = {
@@ -771,6 +844,7 @@ _sixel_overwrite_by_rectangle(
 
                 struct sixel to_be_erased = *six;
                 tll_remove(term->grid->sixel_images, it);
+                sixel_index_invalidate(term->grid);
 
                 sixel_overwrite(term, &to_be_erased, start, col, height, width,
                                 pix, opaque);
@@ -798,6 +872,13 @@ sixel_overwrite_by_rectangle(
     if (likely(tll_length(term->grid->sixel_images) == 0))
         return;
 
+    bool has_images = false;
+    for (int r = 0; r < height && !has_images; r++)
+        has_images = sixel_row_has_images(term->grid, row + r);
+
+    if (!has_images)
+        return;
+
     const int start = (term->grid->offset + row) & (term->grid->num_rows - 1);
     const int end = (start + height - 1) & (term->grid->num_rows - 1);
     const bool wraps = end < start;
@@ -824,7 +905,7 @@ sixel_overwrite_by_row(struct terminal *term, int _row, int col, int width)
     xassert(col >= 0);
     xassert(col < term->grid->num_cols);
 
-    if (likely(tll_length(term->grid->sixel_images) == 0))
+    if (likely(!sixel_row_has_images(term->grid, _row)))
         return;
 
     if (col + width > term->grid->num_cols)
@@ -859,6 +940,7 @@ sixel_overwrite_by_row(struct terminal *term, int _row, int col, int width)
             {
                 struct sixel to_be_erased = *six;
                 tll_remove(term->grid->sixel_images, it);
+                sixel_index_invalidate(term->grid);
 
                 sixel_overwrite(term, &to_be_erased, row, col, 1, width, NULL, NULL);
                 sixel_erase(term, &to_be_erased);
@@ -889,7 +971,64 @@ sixel_cell_size_changed(struct terminal *term)
         sixel_invalidate_cache(&it->item);
 }
 
-void
+static size_t
+drop_scaled_copies(struct grid *grid)
+{
+    size_t freed = 0;
+
+    tll_foreach(grid->sixel_images, it) {
+        struct sixel *six = &it->item;
+
+        if (six->scaled.data == NULL)
+            continue;
+
+        freed += (size_t)six->scaled.width * six->scaled.height * sizeof(uint32_t);
+        sixel_invalidate_cache(six);
+    }
+
+    return freed;
+}
+
+size_t
+sixel_drop_caches(struct terminal *term)
+{
+    return drop_scaled_copies(&term->normal) + drop_scaled_copies(&term->alt);
+}
+
+static void
+scaled_size(const struct terminal *term, const struct sixel *six,
+            int *width, int *height)
+{
+    const double width_ratio = (double)term->cell_width / six->cell_width;
+    const double height_ratio = (double)term->cell_height / six->cell_height;
+
+    *width = (double)six->original.width * width_ratio;
+    *height = (double)six->original.height * height_ratio;
+}
+
+static void
+scale(pixman_image_t *src, int src_width, int src_height,
+      pixman_image_t *dst, int dst_width, int dst_height,
+      pixman_filter_t filter)
+{
+    struct pixman_f_transform scale;
+    pixman_f_transform_init_scale(
+        &scale,
+        (double)src_width / dst_width, (double)src_height / dst_height);
+
+    struct pixman_transform _scale;
+    pixman_transform_from_pixman_f_transform(&_scale, &scale);
+    pixman_image_set_transform(src, &_scale);
+    pixman_image_set_filter(src, filter, NULL, 0);
+
+    pixman_image_composite32(
+        PIXMAN_OP_SRC, src, NULL, dst, 0, 0, 0, 0,
+        0, 0, dst_width, dst_height);
+
+    pixman_image_set_transform(src, NULL);
+}
+
+bool
 sixel_sync_cache(const struct terminal *term, struct sixel *six)
 {
     if (six->pix != NULL) {
@@ -918,7 +1057,7 @@ sixel_sync_cache(const struct terminal *term, struct sixel *six)
             xassert(six->scaled.height >= 0);
         }
 #endif
-        return;
+        return false;
     }
 
     /* Cache should be invalid */
@@ -933,43 +1072,244 @@ sixel_sync_cache(const struct terminal *term, struct sixel *six)
         six->pix = six->original.pix;
         six->width = six->original.width;
         six->height = six->original.height;
-    } else {
-        const double width_ratio = (double)term->cell_width / six->cell_width;
-        const double height_ratio = (double)term->cell_height / six->cell_height;
+        return false;
+    }
 
-        struct pixman_f_transform scale;
-        pixman_f_transform_init_scale(
-            &scale, 1. / width_ratio, 1. / height_ratio);
+    int scaled_width, scaled_height;
+    scaled_size(term, six, &scaled_width, &scaled_height);
+    int scaled_stride = scaled_width * sizeof(uint32_t);
 
-        struct pixman_transform _scale;
-        pixman_transform_from_pixman_f_transform(&_scale, &scale);
-        pixman_image_set_transform(six->original.pix, &_scale);
-        pixman_image_set_filter(six->original.pix, PIXMAN_FILTER_BILINEAR, NULL, 0);
+    LOG_DBG("scaling sixel (preview): %dx%d -> %dx%d",
+            six->original.width, six->original.height,
+            scaled_width, scaled_height);
 
-        int scaled_width = (double)six->original.width * width_ratio;
-        int scaled_height = (double)six->original.height * height_ratio;
-        int scaled_stride = scaled_width * sizeof(uint32_t);
+    uint8_t *scaled_data = xmalloc(scaled_height * scaled_stride);
+    pixman_image_t *scaled_pix = pixman_image_create_bits_no_clear(
+        PIXMAN_a8r8g8b8, scaled_width, scaled_height,
+        (uint32_t *)scaled_data, scaled_stride);
 
-        LOG_DBG("scaling sixel: %dx%d -> %dx%d",
-                six->original.width, six->original.height,
-                scaled_width, scaled_height);
+    scale(six->original.pix, six->original.width, six->original.height,
+          scaled_pix, scaled_width, scaled_height, PIXMAN_FILTER_NEAREST);
 
-        uint8_t *scaled_data = xmalloc(scaled_height * scaled_stride);
-        pixman_image_t *scaled_pix = pixman_image_create_bits_no_clear(
-            PIXMAN_a8r8g8b8, scaled_width, scaled_height,
-            (uint32_t *)scaled_data, scaled_stride);
+    six->scaled.data = scaled_data;
+    six->scaled.pix = six->pix = scaled_pix;
+    six->scaled.width = six->width = scaled_width;
+    six->scaled.height = six->height = scaled_height;
+    six->scaled.preview = true;
+    return true;
+}
 
-        pixman_image_composite32(
-            PIXMAN_OP_SRC, six->original.pix, NULL, scaled_pix, 0, 0, 0, 0,
-            0, 0, scaled_width, scaled_height);
+struct sixel_scale_job *
+sixel_scale_job_new(const struct terminal *term, const struct sixel *six)
+{
+    xassert(six->original.pix != NULL);
+
+    const int stride = pixman_image_get_stride(six->original.pix);
+    const size_t size = (size_t)stride * six->original.height;
+
+    struct sixel_scale_job *job = xmalloc(sizeof(*job));
+    *job = (struct sixel_scale_job){
+        .id = six->id,
+        .cell_width = term->cell_width,
+        .cell_height = term->cell_height,
+        .src = {
+            .data = xmalloc(size),
+            .format = pixman_image_get_format(six->original.pix),
+            .width = six->original.width,
+            .height = six->original.height,
+            .stride = stride,
+        },
+    };
+
+    /* The original may be destroyed while we’re scaling it */
+    memcpy(job->src.data, six->original.data, size);
+    scaled_size(term, six, &job->dst.width, &job->dst.height);
+    return job;
+}
+
+void
+sixel_scale_job_run(struct sixel_scale_job *job)
+{
+    const int dst_stride = job->dst.width * sizeof(uint32_t);
+
+    pixman_image_t *src = pixman_image_create_bits_no_clear(
+        job->src.format, job->src.width, job->src.height,
+        job->src.data, job->src.stride);
+
+    job->dst.data = xmalloc(job->dst.height * dst_stride);
+    pixman_image_t *dst = pixman_image_create_bits_no_clear(
+        PIXMAN_a8r8g8b8, job->dst.width, job->dst.height,
+        job->dst.data, dst_stride);
+
+    scale(src, job->src.width, job->src.height,
+          dst, job->dst.width, job->dst.height, PIXMAN_FILTER_BILINEAR);
 
-        pixman_image_set_transform(six->original.pix, NULL);
+    pixman_image_unref(src);
+    pixman_image_unref(dst);
 
-        six->scaled.data = scaled_data;
-        six->scaled.pix = six->pix = scaled_pix;
-        six->scaled.width = six->width = scaled_width;
-        six->scaled.height = six->height = scaled_height;
+    /* No longer needed */
+    free(job->src.data);
+    job->src.data = NULL;
+}
+
+static struct sixel *
+find_image(struct grid *grid, uint64_t id)
+{
+    tll_foreach(grid->sixel_images, it) {
+        if (it->item.id == id)
+            return &it->item;
     }
+    return NULL;
+}
+
+bool
+sixel_scale_job_apply(struct terminal *term, struct sixel_scale_job *job)
+{
+    if (job->dst.data == NULL)
+        return false;
+
+    if (job->cell_width != term->cell_width ||
+        job->cell_height != term->cell_height)
+    {
+        return false;
+    }
+
+    struct grid *grid = &term->normal;
+    struct sixel *six = find_image(grid, job->id);
+
+    if (six == NULL) {
+        grid = &term->alt;
+        six = find_image(grid, job->id);
+    }
+
+    /* Image destroyed, or the preview has been discarded */
+    if (six == NULL || !six->scaled.preview)
+        return false;
+
+    xassert(six->scaled.width == job->dst.width);
+    xassert(six->scaled.height == job->dst.height);
+
+    LOG_DBG("sixel scaled: %dx%d -> %dx%d",
+            six->original.width, six->original.height,
+            job->dst.width, job->dst.height);
+
+    pixman_image_unref(six->scaled.pix);
+    free(six->scaled.data);
+
+    six->scaled.data = job->dst.data;
+    six->scaled.pix = six->pix = pixman_image_create_bits_no_clear(
+        PIXMAN_a8r8g8b8, job->dst.width, job->dst.height,
+        job->dst.data, job->dst.width * sizeof(uint32_t));
+    six->scaled.preview = false;
+    job->dst.data = NULL;
+
+    /* Re-render the image */
+    for (int i = 0; i < six->rows; i++) {
+        struct row *row = grid->rows[(six->pos.row + i) & (grid->num_rows - 1)];
+        if (row == NULL)
+            continue;
+
+        row->dirty = true;
+
+        for (int c = six->pos.col;
+             c < min(six->pos.col + six->cols, term->cols);
+             c++)
+        {
+            row->cells[c].attrs.clean = 0;
+        }
+    }
+
+    return true;
+}
+
+void
+sixel_scale_job_destroy(struct sixel_scale_job *job)
+{
+    if (job == NULL)
+        return;
+
+    free(job->src.data);
+    free(job->dst.data);
+    free(job);
+}
+
+UNITTEST
+{
+    struct terminal *term = xcalloc(1, sizeof(*term));
+    term->cell_width = 4;
+    term->cell_height = 4;
+    term->grid = &term->normal;
+    term->normal.num_rows = 4;
+    term->normal.rows = xcalloc(4, sizeof(term->normal.rows[0]));
+
+    uint32_t *data = xmalloc(2 * 2 * sizeof(uint32_t));
+    data[0] = data[1] = data[2] = data[3] = 0xff0000ffu;
+
+    /* Emitted with a smaller font; must be scaled up 2x */
+    struct sixel six = {
+        .pix = NULL,
+        .width = -1,
+        .height = -1,
+        .rows = 1,
+        .cols = 1,
+        .id = ++next_image_id,
+        .cell_width = 2,
+        .cell_height = 2,
+        .original = {
+            .data = data,
+            .pix = pixman_image_create_bits_no_clear(
+                PIXMAN_a8r8g8b8, 2, 2, data, 2 * sizeof(uint32_t)),
+            .width = 2,
+            .height = 2,
+        },
+        .scaled = {.width = -1, .height = -1},
+    };
+
+    xassert(sixel_sync_cache(term, &six));
+    xassert(six.scaled.preview);
+    xassert(six.pix == six.scaled.pix);
+    xassert(six.width == 4 && six.height == 4);
+    xassert(((uint32_t *)six.scaled.data)[15] == 0xff0000ffu);
+
+    /* Preview is valid - no need to re-schedule */
+    xassert(!sixel_sync_cache(term, &six));
+
+    tll_push_back(term->normal.sixel_images, six);
+    struct sixel *img = &tll_front(term->normal.sixel_images);
+
+    struct sixel_scale_job *job = sixel_scale_job_new(term, img);
+    xassert(job->dst.width == 4 && job->dst.height == 4);
+    sixel_scale_job_run(job);
+    xassert(job->src.data == NULL);
+    xassert(job->dst.data != NULL);
+
+    /* Stale; cell size has changed since the job was created */
+    term->cell_width = 6;
+    xassert(!sixel_scale_job_apply(term, job));
+    term->cell_width = 4;
+
+    xassert(sixel_scale_job_apply(term, job));
+    xassert(!img->scaled.preview);
+    xassert(img->pix == img->scaled.pix);
+    xassert(img->width == 4 && img->height == 4);
+    xassert(job->dst.data == NULL);
+
+    /* Already applied */
+    xassert(!sixel_scale_job_apply(term, job));
+    sixel_scale_job_destroy(job);
+
+    /* Image destroyed while scaling */
+    sixel_invalidate_cache(img);
+    xassert(sixel_sync_cache(term, img));
+    job = sixel_scale_job_new(term, img);
+    sixel_scale_job_run(job);
+    sixel_destroy(img);
+    tll_free(term->normal.sixel_images);
+    xassert(!sixel_scale_job_apply(term, job));
+    sixel_scale_job_destroy(job);
+
+    free(term->normal.rows);
+    free(term);
 }
 
 void
@@ -984,6 +1324,7 @@ sixel_reflow_grid(struct terminal *term, struct grid *grid)
     tll_foreach(grid->sixel_images, it)
         tll_push_back(copy, it->item);
     tll_free(grid->sixel_images);
+    sixel_index_invalidate(grid);
 
     tll_rforeach(copy, it) {
         struct sixel *six = &it->item;
@@ -1141,6 +1482,7 @@ sixel_unhook(struct terminal *term)
             .cols = (width + term->cell_width - 1) / term->cell_width,
             .pos = (struct coord){start_col, cur_row},
             .opaque = !term->sixel.transparent_bg,
+            .id = ++next_image_id,
             .cell_width = term->cell_width,
             .cell_height = term->cell_height,
             .original = {
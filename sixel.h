@@ -1,5 +1,6 @@
 #pragma once
 
+#include "macros.h"
 #include "terminal.h"
 
 #define SIXEL_MAX_COLORS 1024u
@@ -16,11 +17,95 @@ void sixel_unhook(struct terminal *term);
 void sixel_destroy(struct sixel *sixel);
 void sixel_destroy_all(struct terminal *term);
 
+/*
+ * Rows covered by sixel images. Must be invalidated whenever
+ * grid->sixel_images (or the images’ positions) are modified
+ */
+void sixel_index_rebuild(struct grid *grid);
+
+static inline void
+sixel_index_invalidate(struct grid *grid)
+{
+    grid->sixel_index.valid = false;
+}
+
+/* Row number is absolute */
+static inline bool
+sixel_abs_row_has_images(struct grid *grid, int abs_row)
+{
+    if (likely(tll_length(grid->sixel_images) == 0))
+        return false;
+
+    if (unlikely(!grid->sixel_index.valid ||
+                 grid->sixel_index.num_rows != grid->num_rows))
+    {
+        sixel_index_rebuild(grid);
+    }
+
+    return (grid->sixel_index.rows[abs_row / 64] >> (abs_row % 64)) & 1;
+}
+
+/* Row number is relative to the grid offset */
+static inline bool
+sixel_row_has_images(struct grid *grid, int row)
+{
+    return sixel_abs_row_has_images(
+        grid, (grid->offset + row) & (grid->num_rows - 1));
+}
+
 void sixel_scroll_up(struct terminal *term, int rows);
 void sixel_scroll_down(struct terminal *term, int rows);
 
 void sixel_cell_size_changed(struct terminal *term);
-void sixel_sync_cache(const struct terminal *term, struct sixel *sixel);
+
+/* Frees rescaled image copies (re-created when needed); returns bytes freed */
+size_t sixel_drop_caches(struct terminal *term);
+void sixel_invalidate_cache(struct sixel *sixel);
+
+/*
+ * Ensures sixel->pix is valid. Images emitted with a different cell
+ * size are scaled using a (fast) nearest-neighbor filter; returns
+ * true when this happened, in which case the caller should schedule
+ * a high quality rescale (see below)
+ */
+bool sixel_sync_cache(const struct terminal *term, struct sixel *sixel);
+
+/*
+ * High quality (bilinear) rescaling, of a copy of the original image
+ * data. sixel_scale_job_run() does not touch the terminal, and may be
+ * called from any thread.
+ */
+struct sixel_scale_job {
+    uint64_t id;            /* sixel::id */
+    int cell_width;         /* Cell size we’re scaling to */
+    int cell_height;
+
+    struct {
+        void *data;
+        pixman_format_code_t format;
+        int width;
+        int height;
+        int stride;
+    } src;
+
+    struct {
+        void *data;
+        int width;
+        int height;
+    } dst;
+};
+
+struct sixel_scale_job *sixel_scale_job_new(
+    const struct terminal *term, const struct sixel *sixel);
+void sixel_scale_job_run(struct sixel_scale_job *job);
+
+/*
+ * Replaces the image’s preview with the scaled image, and damages
+ * the image’s rows. Returns false if the job is stale (the image has
+ * been destroyed, the cell size has changed etc)
+ */
+bool sixel_scale_job_apply(struct terminal *term, struct sixel_scale_job *job);
+void sixel_scale_job_destroy(struct sixel_scale_job *job);
 
 void sixel_reflow_grid(struct terminal *term, struct grid *grid);
 
@@ -19,69 +19,13 @@
 
 #include "debug.h"
 #include "macros.h"
+#include "spawn.h"
 #include "terminal.h"
 #include "tokenize.h"
 #include "xmalloc.h"
 
 extern char **environ;
 
-#if defined(__FreeBSD__)
-static char *
-find_file_in_path(const char *file)
-{
-    if (strchr(file, '/') != NULL)
-        return xstrdup(file);
-
-    const char *env_path = getenv("PATH");
-    char *path_list = NULL;
-
-    if (env_path != NULL && env_path[0] != '\0')
-        path_list = xstrdup(env_path);
-    else {
-        size_t sc_path_len = confstr(_CS_PATH, NULL, 0);
-        if (sc_path_len > 0) {
-            path_list = xmalloc(sc_path_len);
-            confstr(_CS_PATH, path_list, sc_path_len);
-        } else
-            return xstrdup(file);
-    }
-
-    for (const char *path = strtok(path_list, ":");
-         path != NULL;
-         path = strtok(NULL, ":"))
-    {
-        char *full = xasprintf("%s/%s", path, file);
-        if (access(full, F_OK) == 0) {
-            free(path_list);
-            return full;
-        }
-
-        free(full);
-    }
-
-    free(path_list);
-    return xstrdup(file);
-}
-
-static int
-foot_execvpe(const char *file, char *const argv[], char *const envp[])
-{
-    char *path = find_file_in_path(file);
-    int ret = execve(path, argv, envp);
-
-    /*
-     * Getting here is an error
-     */
-    free(path);
-    return ret;
-}
-
-#else   /* !__FreeBSD__ */
-
-#define foot_execvpe(file, argv, envp) execvpe(file, argv, envp)
-
-#endif  /* !__FreeBSD__ */
-
 static bool
 is_valid_shell(const char *shell)
 {
@@ -117,6 +61,7 @@ is_valid_shell(const char *shell)
             continue;
 
         if (strcmp(line, shell) == 0) {
+            free(_line);
             fclose(f);
             return true;
         }
@@ -165,10 +110,8 @@ emit_one_notification(int fd, const struct user_notification *notif)
          */
         if (errno == EWOULDBLOCK || errno == EAGAIN)
             return UN_NO_MORE;
-        else {
-            LOG_ERRNO("failed to write user-notification");
+        else
             return UN_FAIL;
-        }
     }
 
     return UN_OK;
@@ -203,54 +146,49 @@ emit_notifications(int fd, const user_notifications_t *notifications)
         emit_notifications_of_kind(fd, notifications, USER_NOTIFICATION_DEPRECATED);
 }
 
+/*
+ * Runs in the vfork():ed child. It shares our address space, and may
+ * thus only call async-signal-safe functions, and must not modify
+ * any memory (except its own stack). Errors are reported to the
+ * parent, through ‘err_fd’.
+ */
 static noreturn void
-slave_exec(int ptmx, char *argv[], char *const envp[], int err_fd,
-           bool login_shell, const user_notifications_t *notifications)
+slave_exec(int ptmx, const char *pts_name, const char *cwd,
+           const char *file, char *const argv[], char *const envp[],
+           int err_fd, const user_notifications_t *notifications)
 {
     int pts = -1;
-    const char *pts_name = ptsname(ptmx);
 
-    if (grantpt(ptmx) == -1) {
-        LOG_ERRNO("failed to grantpt()");
+    if (chdir(cwd) < 0)
         goto err;
-    }
-    if (unlockpt(ptmx) == -1) {
-        LOG_ERRNO("failed to unlockpt()");
+
+    /* Restore signal mask, and SIG_IGN'd signals */
+    if (spawn_child_reset_signals() < 0)
         goto err;
-    }
 
     close(ptmx);
     ptmx = -1;
 
-    if (setsid() == -1) {
-        LOG_ERRNO("failed to setsid()");
+    if (setsid() == -1)
         goto err;
-    }
 
     pts = open(pts_name, O_RDWR);
-    if (pts == -1) {
-        LOG_ERRNO("failed to open pseudo terminal slave device");
+    if (pts == -1)
         goto err;
-    }
 
-    if (ioctl(pts, TIOCSCTTY, 0) < 0) {
-        LOG_ERRNO("failed to configure controlling terminal");
+    /* Make it our controlling terminal */
+    if (ioctl(pts, TIOCSCTTY, 0) < 0)
         goto err;
-    }
 
 #ifdef IUTF8
     {
         struct termios flags;
-        if (tcgetattr(pts, &flags) < 0) {
-            LOG_ERRNO("failed to get terminal attributes");
+        if (tcgetattr(pts, &flags) < 0)
             goto err;
-        }
 
         flags.c_iflag |= IUTF8;
-        if (tcsetattr(pts, TCSANOW, &flags) < 0) {
-            LOG_ERRNO("failed to set IUTF8 terminal attribute");
+        if (tcsetattr(pts, TCSANOW, &flags) < 0)
             goto err;
-        }
     }
 #endif
 
@@ -271,36 +209,24 @@ slave_exec(int ptmx, char *argv[], char *const envp[], int err_fd,
         dup2(pts, STDOUT_FILENO) == -1 ||
         dup2(pts, STDERR_FILENO) == -1)
     {
-        LOG_ERRNO("failed to dup stdin/stdout/stderr");
         goto err;
     }
 
     close(pts);
     pts = -1;
 
-    const char *file;
-    if (login_shell) {
-        file = xstrdup(argv[0]);
-
-        char *arg0 = xmalloc(strlen(argv[0]) + 1 + 1);
-        arg0[0] = '-';
-        arg0[1] = '\0';
-        strcat(arg0, argv[0]);
-
-        argv[0] = arg0;
-    } else
-        file = argv[0];
-
-    foot_execvpe(file, argv, envp);
+    spawn_execvpe(file, argv, envp);
 
 err:
-    (void)!write(err_fd, &errno, sizeof(errno));
+    ;
+    const int errno_copy = errno;
+    (void)!write(err_fd, &errno_copy, sizeof(errno_copy));
     if (pts != -1)
         close(pts);
     if (ptmx != -1)
         close(ptmx);
     close(err_fd);
-    _exit(errno);
+    _exit(errno_copy);
 }
 
 pid_t
@@ -309,56 +235,83 @@ slave_spawn(int ptmx, int argc, const char *cwd, char *const *argv,
             const char *term_env, const char *conf_shell, bool login_shell,
             const user_notifications_t *notifications)
 {
-    int fork_pipe[2];
-    if (pipe2(fork_pipe, O_CLOEXEC) < 0) {
-        LOG_ERRNO("failed to create pipe");
+    /*
+     * The child is vfork():ed, and shares our address space until it
+     * has exec:d. Thus, everything it needs (argv, environment,
+     * executable path etc) is prepared here, up front.
+     */
+
+    if (grantpt(ptmx) == -1) {
+        LOG_ERRNO("failed to grantpt()");
+        return -1;
+    }
+    if (unlockpt(ptmx) == -1) {
+        LOG_ERRNO("failed to unlockpt()");
         return -1;
     }
 
-    pid_t pid = fork();
-    switch (pid) {
-    case -1:
-        LOG_ERRNO("failed to fork");
-        close(fork_pipe[0]);
-        close(fork_pipe[1]);
+    const char *_pts_name = ptsname(ptmx);
+    if (_pts_name == NULL) {
+        LOG_ERRNO("failed to get pseudo terminal slave device name");
         return -1;
+    }
 
-    case 0:
-        /* Child */
-        close(fork_pipe[0]);  /* Close read end */
+    char *pts_name = xstrdup(_pts_name);
+    char **tokenized_argv = NULL;
+    char **shell_argv = NULL;
+    char *arg0 = NULL;
+    char *file = NULL;
+    struct spawn_env env = {0};
+    int fork_pipe[2] = {-1, -1};
+    pid_t pid = -1;
+
+    if (argc == 0) {
+        if (!tokenize_cmdline(conf_shell, &tokenized_argv))
+            goto out;
+
+        size_t count = 0;
+        for (; tokenized_argv[count] != NULL; count++)
+            ;
+        shell_argv = xmalloc((count + 1) * sizeof(shell_argv[0]));
+        memcpy(shell_argv, tokenized_argv, (count + 1) * sizeof(shell_argv[0]));
+    } else {
+        size_t count = 0;
+        for (; argv[count] != NULL; count++)
+            ;
+        shell_argv = xmalloc((count + 1) * sizeof(shell_argv[0]));
+        for (size_t i = 0; i < count; i++)
+            shell_argv[i] = argv[i];
+        shell_argv[count] = NULL;
+    }
 
-        if (chdir(cwd) < 0) {
-            const int errno_copy = errno;
-            LOG_ERRNO("failed to change working directory to %s", cwd);
-            (void)!write(fork_pipe[1], &errno_copy, sizeof(errno_copy));
-            _exit(errno_copy);
-        }
+    const char *shell = shell_argv[0];
+    file = spawn_resolve_executable(shell);
+
+    if (login_shell) {
+        arg0 = xmalloc(strlen(shell_argv[0]) + 1 + 1);
+        arg0[0] = '-';
+        arg0[1] = '\0';
+        strcat(arg0, shell_argv[0]);
 
-        /* Restore signal mask, and SIG_IGN'd signals */
-        struct sigaction dfl = {.sa_handler = SIG_DFL};
-        sigemptyset(&dfl.sa_mask);
-        sigset_t mask;
-        sigemptyset(&mask);
+        shell_argv[0] = arg0;
+    }
 
-        if (sigprocmask(SIG_SETMASK, &mask, NULL) < 0 ||
-            sigaction(SIGHUP, &dfl, NULL) < 0 ||
-            sigaction(SIGPIPE, &dfl, NULL) < 0)
-        {
-            const int errno_copy = errno;
-            LOG_ERRNO_P(errno, "failed to restore signals");
-            (void)!write(fork_pipe[1], &errno_copy, sizeof(errno_copy));
-            _exit(errno_copy);
-        }
+    /*
+     * Note: the modifications are only applied to our own environment;
+     * a custom environment (e.g. from footclient) is used as-is.
+     */
+    spawn_env_init(&env, envp != NULL ? envp : environ);
 
-        setenv("TERM", term_env, 1);
-        setenv("COLORTERM", "truecolor", 1);
-        setenv("PWD", cwd, 1);
+    if (envp == NULL) {
+        spawn_env_set(&env, "TERM", term_env);
+        spawn_env_set(&env, "COLORTERM", "truecolor");
+        spawn_env_set(&env, "PWD", cwd);
 
-        unsetenv("TERM_PROGRAM");
-        unsetenv("TERM_PROGRAM_VERSION");
+        spawn_env_set(&env, "TERM_PROGRAM", NULL);
+        spawn_env_set(&env, "TERM_PROGRAM_VERSION", NULL);
 
 #if defined(FOOT_TERMINFO_PATH)
-        setenv("TERMINFO", FOOT_TERMINFO_PATH, 1);
+        spawn_env_set(&env, "TERMINFO", FOOT_TERMINFO_PATH);
 #endif
 
         if (extra_env_vars != NULL) {
@@ -366,71 +319,87 @@ slave_spawn(int ptmx, int argc, const char *cwd, char *const *argv,
                 const char *name = it->item.name;
                 const char *value = it->item.value;
 
-                if (strlen(value) == 0)
-                    unsetenv(name);
-                else
-                    setenv(name, value, 1);
+                spawn_env_set(&env, name, strlen(value) == 0 ? NULL : value);
             }
         }
 
-        char **_shell_argv = NULL;
-        char **shell_argv = NULL;
+        if (is_valid_shell(shell))
+            spawn_env_set(&env, "SHELL", shell);
+    }
 
-        if (argc == 0) {
-            if (!tokenize_cmdline(conf_shell, &_shell_argv)) {
-                (void)!write(fork_pipe[1], &errno, sizeof(errno));
-                _exit(0);
-            }
-            shell_argv = _shell_argv;
-        } else {
-            size_t count = 0;
-            for (; argv[count] != NULL; count++)
-                ;
-            shell_argv = xmalloc((count + 1) * sizeof(shell_argv[0]));
-            for (size_t i = 0; i < count; i++)
-                shell_argv[i] = argv[i];
-            shell_argv[count] = NULL;
-        }
+    if (pipe2(fork_pipe, O_CLOEXEC) < 0) {
+        LOG_ERRNO("failed to create pipe");
+        goto out;
+    }
 
-        if (is_valid_shell(shell_argv[0]))
-            setenv("SHELL", shell_argv[0], 1);
+    /* Block all signals, to prevent our handlers from running in the
+     * child, before it has reset them */
+    sigset_t all, orig_mask;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &orig_mask);
+
+    /* No copying of page tables; spawn latency does not depend on
+     * how much memory we’re using */
+    pid = vfork();
+    if (pid == 0) {
+        slave_exec(ptmx, pts_name, cwd, file, shell_argv, env.vars,
+                   fork_pipe[1], notifications);
+    }
 
-        slave_exec(ptmx, shell_argv, envp != NULL ? envp : environ,
-                   fork_pipe[1], login_shell, notifications);
-        BUG("Unexpected return from slave_exec()");
-        break;
+    const int vfork_errno = errno;
+    pthread_sigmask(SIG_SETMASK, &orig_mask, NULL);
 
-    default: {
-        close(fork_pipe[1]); /* Close write end */
-        LOG_DBG("slave has PID %d", pid);
+    if (pid < 0) {
+        LOG_ERRNO_P(vfork_errno, "failed to fork");
+        goto out;
+    }
 
-        int errno_copy;
-        static_assert(sizeof(errno) == sizeof(errno_copy), "errno size mismatch");
+    close(fork_pipe[1]); /* Close write end */
+    fork_pipe[1] = -1;
+    LOG_DBG("slave has PID %d", pid);
+
+    int errno_copy;
+    static_assert(sizeof(errno) == sizeof(errno_copy), "errno size mismatch");
+
+    ssize_t ret = read(fork_pipe[0], &errno_copy, sizeof(errno_copy));
+
+    if (ret < 0) {
+        LOG_ERRNO("failed to read from pipe");
+        pid = -1;
+        goto out;
+    } else if (ret == sizeof(errno_copy)) {
+        LOG_ERRNO_P(
+            errno_copy, "%s: failed to execute",
+            argc == 0 ? conf_shell : argv[0]);
+        pid = -1;
+        goto out;
+    } else
+        LOG_DBG("%s: successfully started", conf_shell);
 
-        ssize_t ret = read(fork_pipe[0], &errno_copy, sizeof(errno_copy));
+    int fd_flags;
+    if ((fd_flags = fcntl(ptmx, F_GETFD)) < 0 ||
+        fcntl(ptmx, F_SETFD, fd_flags | FD_CLOEXEC) < 0)
+    {
+        LOG_ERRNO("failed to set FD_CLOEXEC on ptmx");
+        pid = -1;
+        goto out;
+    }
+
+out:
+    if (fork_pipe[0] != -1)
         close(fork_pipe[0]);
+    if (fork_pipe[1] != -1)
+        close(fork_pipe[1]);
 
-        if (ret < 0) {
-            LOG_ERRNO("failed to read from pipe");
-            return -1;
-        } else if (ret == sizeof(errno_copy)) {
-            LOG_ERRNO_P(
-                errno_copy, "%s: failed to execute",
-                argc == 0 ? conf_shell : argv[0]);
-            return -1;
-        } else
-            LOG_DBG("%s: successfully started", conf_shell);
-
-        int fd_flags;
-        if ((fd_flags = fcntl(ptmx, F_GETFD)) < 0 ||
-            fcntl(ptmx, F_SETFD, fd_flags | FD_CLOEXEC) < 0)
-        {
-            LOG_ERRNO("failed to set FD_CLOEXEC on ptmx");
-            return -1;
-        }
-        break;
+    spawn_env_free(&env);
+    free(file);
+    free(arg0);
+    free(shell_argv);
+    if (tokenized_argv != NULL) {
+        for (char **arg = tokenized_argv; *arg != NULL; arg++)
+            free(*arg);
+        free(tokenized_argv);
     }
-    }
-
+    free(pts_name);
     return pid;
 }
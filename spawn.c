@@ -1,5 +1,6 @@
 #include "spawn.h"
 
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
@@ -13,8 +14,206 @@
 #define LOG_ENABLE_DBG 0
 #include "log.h"
 #include "debug.h"
+#include "macros.h"
 #include "xmalloc.h"
 
+extern char **environ;
+
+#if defined(__FreeBSD__)
+static char *
+find_file_in_path(const char *file)
+{
+    if (strchr(file, '/') != NULL)
+        return xstrdup(file);
+
+    const char *env_path = getenv("PATH");
+    char *path_list = NULL;
+
+    if (env_path != NULL && env_path[0] != '\0')
+        path_list = xstrdup(env_path);
+    else {
+        size_t sc_path_len = confstr(_CS_PATH, NULL, 0);
+        if (sc_path_len > 0) {
+            path_list = xmalloc(sc_path_len);
+            confstr(_CS_PATH, path_list, sc_path_len);
+        } else
+            return xstrdup(file);
+    }
+
+    for (const char *path = strtok(path_list, ":");
+         path != NULL;
+         path = strtok(NULL, ":"))
+    {
+        char *full = xasprintf("%s/%s", path, file);
+        if (access(full, F_OK) == 0) {
+            free(path_list);
+            return full;
+        }
+
+        free(full);
+    }
+
+    free(path_list);
+    return xstrdup(file);
+}
+#endif
+
+char *
+spawn_resolve_executable(const char *file)
+{
+#if defined(__FreeBSD__)
+    /* No execvpe(); search $PATH now, and use execve() in the child */
+    return find_file_in_path(file);
+#else
+    return xstrdup(file);
+#endif
+}
+
+int
+spawn_execvpe(const char *file, char *const argv[], char *const envp[])
+{
+#if defined(__FreeBSD__)
+    return execve(file, argv, envp);
+#else
+    return execvpe(file, argv, envp);
+#endif
+}
+
+void
+spawn_env_init(struct spawn_env *env, char *const *envp)
+{
+    *env = (struct spawn_env){0};
+
+    for (; envp != NULL && *envp != NULL; envp++) {
+        env->vars = xrealloc(env->vars, (env->count + 2) * sizeof(env->vars[0]));
+        env->vars[env->count++] = xstrdup(*envp);
+    }
+
+    env->vars = xrealloc(env->vars, (env->count + 1) * sizeof(env->vars[0]));
+    env->vars[env->count] = NULL;
+}
+
+void
+spawn_env_set(struct spawn_env *env, const char *name, const char *value)
+{
+    const size_t name_len = strlen(name);
+
+    for (size_t i = 0; i < env->count; i++) {
+        if (strncmp(env->vars[i], name, name_len) != 0 ||
+            env->vars[i][name_len] != '=')
+        {
+            continue;
+        }
+
+        free(env->vars[i]);
+
+        if (value != NULL)
+            env->vars[i] = xasprintf("%s=%s", name, value);
+        else {
+            memmove(&env->vars[i], &env->vars[i + 1],
+                    (env->count - i) * sizeof(env->vars[0]));
+            env->count--;
+        }
+        return;
+    }
+
+    if (value == NULL)
+        return;
+
+    env->vars = xrealloc(env->vars, (env->count + 2) * sizeof(env->vars[0]));
+    env->vars[env->count++] = xasprintf("%s=%s", name, value);
+    env->vars[env->count] = NULL;
+}
+
+void
+spawn_env_free(struct spawn_env *env)
+{
+    for (size_t i = 0; i < env->count; i++)
+        free(env->vars[i]);
+    free(env->vars);
+    *env = (struct spawn_env){0};
+}
+
+int
+spawn_child_reset_signals(void)
+{
+    /*
+     * Handlers must be reset *before* unblocking signals; a handler
+     * running in the child would run in our (the parent’s) address
+     * space.
+     */
+    const struct sigaction dfl = {.sa_handler = SIG_DFL};
+
+    for (int sig = 1; sig < NSIG; sig++) {
+        struct sigaction old;
+        if (sigaction(sig, NULL, &old) < 0)
+            continue;
+
+        if (old.sa_handler == SIG_DFL || old.sa_handler == SIG_IGN)
+            continue;
+
+        if (sigaction(sig, &dfl, NULL) < 0)
+            return -1;
+    }
+
+    /* Restore the signals we ignore (SIG_IGN) */
+    if (sigaction(SIGHUP, &dfl, NULL) < 0 ||
+        sigaction(SIGPIPE, &dfl, NULL) < 0)
+    {
+        return -1;
+    }
+
+    /* Clear signal mask */
+    sigset_t mask;
+    sigemptyset(&mask);
+    return sigprocmask(SIG_SETMASK, &mask, NULL);
+}
+
+/*
+ * Runs in the vfork():ed child; may only call async-signal-safe
+ * functions, and must not modify any memory, since it is shared with
+ * the (suspended) parent.
+ */
+static noreturn void
+spawn_child(int err_fd, const char *cwd, const char *file,
+            char *const argv[], char *const envp[],
+            int stdin_fd, int stdout_fd, int stderr_fd)
+{
+    if (spawn_child_reset_signals() < 0)
+        goto child_err;
+
+    if (setsid() < 0)
+        goto child_err;
+
+    if (cwd != NULL) {
+        /* Not a fatal error */
+        (void)!chdir(cwd);
+    }
+
+    bool close_stderr = stderr_fd >= 0;
+    bool close_stdout = stdout_fd >= 0 && stdout_fd != stderr_fd;
+    bool close_stdin = stdin_fd >= 0 && stdin_fd != stdout_fd && stdin_fd != stderr_fd;
+
+    if ((stdin_fd >= 0 && (dup2(stdin_fd, STDIN_FILENO) < 0
+                           || (close_stdin && close(stdin_fd) < 0))) ||
+        (stdout_fd >= 0 && (dup2(stdout_fd, STDOUT_FILENO) < 0
+                            || (close_stdout && close(stdout_fd) < 0))) ||
+        (stderr_fd >= 0 && (dup2(stderr_fd, STDERR_FILENO) < 0
+                            || (close_stderr && close(stderr_fd) < 0))) ||
+        spawn_execvpe(file, argv, envp) < 0)
+    {
+        goto child_err;
+    }
+
+    xassert(false);
+
+child_err:
+    ;
+    const int errno_copy = errno;
+    (void)!write(err_fd, &errno_copy, sizeof(errno_copy));
+    _exit(errno_copy);
+}
+
 bool
 spawn(struct reaper *reaper, const char *cwd, char *const argv[],
       int stdin_fd, int stdout_fd, int stderr_fd,
@@ -26,72 +225,59 @@ spawn(struct reaper *reaper, const char *cwd, char *const argv[],
         goto err;
     }
 
-    pid_t pid = fork();
-    if (pid < 0) {
-        LOG_ERRNO("failed to fork");
-        goto err;
+    /*
+     * Everything the child needs is prepared up front; it shares our
+     * address space, and thus cannot allocate memory, nor modify the
+     * environment.
+     */
+    struct spawn_env env;
+    spawn_env_init(&env, environ);
+
+    if (cwd != NULL) {
+        spawn_env_set(&env, "PWD", cwd);
+
+        struct stat st;
+        if (stat(cwd, &st) < 0 || !S_ISDIR(st.st_mode)) {
+            LOG_WARN("failed to change working directory to %s: %s",
+                     cwd, strerror(errno));
+        }
     }
 
-    if (pid == 0) {
-        /* Child */
-        close(pipe_fds[0]);
-
-        if (setsid() < 0)
-            goto child_err;
-
-        /* Clear signal mask */
-        sigset_t mask;
-        sigemptyset(&mask);
-        if (sigprocmask(SIG_SETMASK, &mask, NULL) < 0)
-            goto child_err;
+    if (xdg_activation_token != NULL) {
+        spawn_env_set(&env, "XDG_ACTIVATION_TOKEN", xdg_activation_token);
 
-        /* Restore ignored (SIG_IGN) signals */
-        struct sigaction dfl = {.sa_handler = SIG_DFL};
-        sigemptyset(&dfl.sa_mask);
-        if (sigaction(SIGHUP, &dfl, NULL) < 0 ||
-            sigaction(SIGPIPE, &dfl, NULL) < 0)
-        {
-            goto child_err;
-        }
+        if (getenv("DISPLAY") != NULL)
+            spawn_env_set(&env, "DESKTOP_STARTUP_ID", xdg_activation_token);
+    }
 
-        if (cwd != NULL) {
-            setenv("PWD", cwd, 1);
-            if (chdir(cwd) < 0) {
-                LOG_WARN("failed to change working directory to %s: %s",
-                         cwd, strerror(errno));
-            }
-        }
+    char *file = spawn_resolve_executable(argv[0]);
 
-        if (xdg_activation_token != NULL) {
-            setenv("XDG_ACTIVATION_TOKEN", xdg_activation_token, 1);
+    /* Block all signals, to prevent our handlers from running in the
+     * child, before it has reset them */
+    sigset_t all, orig_mask;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &orig_mask);
 
-            if (getenv("DISPLAY") != NULL)
-                setenv("DESKTOP_STARTUP_ID", xdg_activation_token, 1);
-        }
+    /*
+     * vfork() doesn’t copy our page tables, making spawning
+     * independent of our memory usage (which can be large, when
+     * hosting many terminals with lots of scrollback)
+     */
+    pid_t pid = vfork();
+    if (pid == 0) {
+        spawn_child(pipe_fds[1], cwd, file, argv, env.vars,
+                    stdin_fd, stdout_fd, stderr_fd);
+    }
 
-        bool close_stderr = stderr_fd >= 0;
-        bool close_stdout = stdout_fd >= 0 && stdout_fd != stderr_fd;
-        bool close_stdin = stdin_fd >= 0 && stdin_fd != stdout_fd && stdin_fd != stderr_fd;
-
-        if ((stdin_fd >= 0 && (dup2(stdin_fd, STDIN_FILENO) < 0
-                               || (close_stdin && close(stdin_fd) < 0))) ||
-            (stdout_fd >= 0 && (dup2(stdout_fd, STDOUT_FILENO) < 0
-                                || (close_stdout && close(stdout_fd) < 0))) ||
-            (stderr_fd >= 0 && (dup2(stderr_fd, STDERR_FILENO) < 0
-                                || (close_stderr && close(stderr_fd) < 0))) ||
-            execvp(argv[0], argv) < 0)
-        {
-            goto child_err;
-        }
+    const int vfork_errno = errno;
+    pthread_sigmask(SIG_SETMASK, &orig_mask, NULL);
 
-        xassert(false);
-        _exit(errno);
+    free(file);
+    spawn_env_free(&env);
 
-    child_err:
-        ;
-        const int errno_copy = errno;
-        (void)!write(pipe_fds[1], &errno_copy, sizeof(errno_copy));
-        _exit(errno_copy);
+    if (pid < 0) {
+        LOG_ERRNO_P(vfork_errno, "failed to fork");
+        goto err;
     }
 
     /* Parent */
@@ -8,6 +8,29 @@ bool spawn(struct reaper *reaper, const char *cwd, char *const argv[],
            int stdin_fd, int stdout_fd, int stderr_fd,
            const char *xdg_activation_token);
 
+/*
+ * Helpers for spawning processes with vfork(). The child shares our
+ * address space until it has exec:d, and must thus not allocate
+ * memory, nor modify the environment. Instead, everything it needs
+ * is prepared before forking.
+ */
+struct spawn_env {
+    char **vars;    /* NULL terminated */
+    size_t count;
+};
+
+void spawn_env_init(struct spawn_env *env, char *const *envp);
+void spawn_env_set(  /* value == NULL unsets the variable */
+    struct spawn_env *env, const char *name, const char *value);
+void spawn_env_free(struct spawn_env *env);
+
+/* Must be called before forking; returns a path for spawn_execvpe() */
+char *spawn_resolve_executable(const char *file);
+
+/* Async-signal-safe; for use in the vfork():ed child */
+int spawn_execvpe(const char *file, char *const argv[], char *const envp[]);
+int spawn_child_reset_signals(void);
+
 bool spawn_expand_template(
     const struct config_spawn_template *template,
     size_t key_count, const char *key_names[static key_count],
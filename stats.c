@@ -0,0 +1,388 @@
+#include "stats.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "config.h"
+#include "debug.h"
+#include "macros.h"
+#include "shm.h"
+#include "util.h"
+#include "xmalloc.h"
+
+/* Upper bounds (exclusive) of all but the last histogram bucket */
+static const uint64_t frame_time_limits_ns[TERM_STATS_FRAME_TIME_BUCKETS - 1] = {
+    250000, 500000, 1000000, 2000000, 4000000, 8000000, 16000000, 32000000,
+};
+
+static const char *const frame_time_names[TERM_STATS_FRAME_TIME_BUCKETS] = {
+    "<250µs", "<500µs", "<1ms", "<2ms", "<4ms", "<8ms", "<16ms", "<32ms",
+    "≥32ms",
+};
+
+size_t
+stats_frame_time_bucket(uint64_t ns)
+{
+    for (size_t i = 0; i < ALEN(frame_time_limits_ns); i++) {
+        if (ns < frame_time_limits_ns[i])
+            return i;
+    }
+
+    return TERM_STATS_FRAME_TIME_BUCKETS - 1;
+}
+
+void
+stats_frame_rendered(struct term_stats *stats, uint64_t ns, size_t rows)
+{
+    stats->render.frames++;
+    stats->render.ns += ns;
+    stats->render.rows += rows;
+    stats->render.frame_times[stats_frame_time_bucket(ns)]++;
+
+    if (ns > stats->render.max_ns)
+        stats->render.max_ns = ns;
+    if (rows > stats->render.max_rows)
+        stats->render.max_rows = rows;
+}
+
+/* Growable string buffer */
+struct strbuf {
+    char *s;
+    size_t len;
+    size_t size;
+};
+
+static void PRINTF(2)
+strbuf_printf(struct strbuf *buf, const char *fmt, ...)
+{
+    va_list va;
+    va_start(va, fmt);
+    int n = vsnprintf(NULL, 0, fmt, va);
+    va_end(va);
+
+    xassert(n >= 0);
+
+    if (buf->len + n + 1 > buf->size) {
+        size_t new_size = buf->size == 0 ? 1024 : buf->size;
+        while (buf->len + n + 1 > new_size)
+            new_size *= 2;
+
+        buf->s = xrealloc(buf->s, new_size);
+        buf->size = new_size;
+    }
+
+    va_start(va, fmt);
+    vsnprintf(&buf->s[buf->len], buf->size - buf->len, fmt, va);
+    va_end(va);
+
+    buf->len += n;
+}
+
+static void
+strbuf_json_string(struct strbuf *buf, const char *str)
+{
+    strbuf_printf(buf, "\"");
+
+    for (const char *p = str != NULL ? str : ""; *p != '\0'; p++) {
+        const unsigned char c = *p;
+
+        switch (c) {
+        case '"':  strbuf_printf(buf, "\\\""); break;
+        case '\\': strbuf_printf(buf, "\\\\"); break;
+        case '\n': strbuf_printf(buf, "\\n"); break;
+        case '\r': strbuf_printf(buf, "\\r"); break;
+        case '\t': strbuf_printf(buf, "\\t"); break;
+
+        default:
+            if (c < 0x20 || c == 0x7f)
+                strbuf_printf(buf, "\\u%04x", c);
+            else
+                strbuf_printf(buf, "%c", c);
+            break;
+        }
+    }
+
+    strbuf_printf(buf, "\"");
+}
+
+static double
+ns_to_ms(uint64_t ns)
+{
+    return ns / 1000000.;
+}
+
+static double
+bytes_to_mib(uint64_t bytes)
+{
+    return bytes / (1024. * 1024.);
+}
+
+char *
+stats_to_text(const struct terminal *term)
+{
+    const struct term_stats *stats = &term->stats;
+    const struct buffer_chain_stats *shm =
+        shm_chain_stats(term->render.chains.grid);
+    const __typeof__(term->render.app_sync_updates) *sync =
+        &term->render.app_sync_updates;
+
+    struct strbuf buf = {0};
+
+    const double parse_ms = ns_to_ms(stats->parse.ns);
+    strbuf_printf(
+        &buf, "parse:    %.2f MiB in %.1f ms (%.1f MiB/s), %" PRIu64 " throttled\n",
+        bytes_to_mib(stats->parse.bytes), parse_ms,
+        parse_ms > 0. ? bytes_to_mib(stats->parse.bytes) / (parse_ms / 1000.) : 0.,
+        stats->parse.throttled);
+
+    const uint64_t frames = stats->render.frames;
+    strbuf_printf(
+        &buf, "frames:   %" PRIu64 " rendered, %" PRIu64 " deferred\n",
+        frames, stats->render.deferred);
+    strbuf_printf(
+        &buf, "render:   avg %.2f ms, max %.2f ms\n",
+        frames > 0 ? ns_to_ms(stats->render.ns / frames) : 0.,
+        ns_to_ms(stats->render.max_ns));
+    strbuf_printf(
+        &buf, "rows:     avg %.1f, max %" PRIu64 "\n",
+        frames > 0 ? (double)stats->render.rows / frames : 0.,
+        stats->render.max_rows);
+
+    for (size_t i = 0; i < TERM_STATS_FRAME_TIME_BUCKETS; i++) {
+        strbuf_printf(
+            &buf, "%s%s:%" PRIu64 "%s",
+            i == 0 ? "times:    " : i == 5 ? "          " : "",
+            frame_time_names[i], stats->render.frame_times[i],
+            i == 4 || i == TERM_STATS_FRAME_TIME_BUCKETS - 1 ? "\n" : " ");
+    }
+
+    strbuf_printf(
+        &buf, "scroll:   %" PRIu64 " shm, %" PRIu64 " memmove\n",
+        stats->scroll.shm, stats->scroll.memmove);
+    strbuf_printf(
+        &buf, "damage:   %" PRIu64 " rects, %" PRIu64 " sent\n",
+        stats->damage.rects, stats->damage.sent);
+    strbuf_printf(
+        &buf, "buffers:  %" PRIu64 " reused, %" PRIu64 " allocated\n",
+        shm->reused, shm->allocated);
+    strbuf_printf(
+        &buf, "sync:     %" PRIu64 " updates, %" PRIu64 " timeouts, "
+        "timeout %.0f ms\n",
+        sync->stats.count, sync->stats.timeouts, ns_to_ms(sync->timeout_ns));
+    strbuf_printf(&buf, "composed: %zu", term->composed_count);
+
+    return buf.s;
+}
+
+static void
+grid_memory_usage(const struct grid *grid, int screen_rows,
+                  size_t *scrollback_rows, size_t *row_bytes,
+                  size_t *sixel_count, size_t *sixel_bytes)
+{
+    size_t rows = 0;
+    for (int r = 0; r < grid->num_rows; r++) {
+        const struct row *row = grid->rows[r];
+        if (row == NULL)
+            continue;
+
+        rows++;
+        *row_bytes += sizeof(*row) + grid->num_cols * sizeof(row->cells[0]);
+
+        if (row->extra != NULL) {
+            *row_bytes += sizeof(*row->extra) +
+                row->extra->uri_ranges.size * sizeof(row->extra->uri_ranges.v[0]);
+        }
+    }
+
+    *scrollback_rows += rows > (size_t)screen_rows ? rows - screen_rows : 0;
+
+    tll_foreach(grid->sixel_images, it) {
+        const struct sixel *six = &it->item;
+
+        (*sixel_count)++;
+        *sixel_bytes +=
+            (size_t)six->original.width * six->original.height * sizeof(uint32_t);
+
+        if (six->scaled.data != NULL) {
+            *sixel_bytes +=
+                (size_t)six->scaled.width * six->scaled.height * sizeof(uint32_t);
+        }
+    }
+}
+
+static void
+terminal_identity_to_json(struct strbuf *buf, const struct terminal *term)
+{
+    strbuf_printf(
+        buf, "\"id\":%" PRIu32 ",\"pid\":%d,\"title\":",
+        term->id, (int)term->slave);
+    strbuf_json_string(buf, term->window_title);
+    strbuf_printf(buf, ",\"app_id\":");
+    strbuf_json_string(buf, term->conf->app_id);
+    strbuf_printf(
+        buf, ",\"cols\":%d,\"rows\":%d", term->cols, term->rows);
+}
+
+static void
+terminal_to_json(struct strbuf *buf, const struct terminal *term)
+{
+    const struct term_stats *stats = &term->stats;
+    const struct buffer_chain_stats *shm =
+        shm_chain_stats(term->render.chains.grid);
+    const __typeof__(term->render.app_sync_updates) *sync =
+        &term->render.app_sync_updates;
+
+    strbuf_printf(buf, "{");
+    terminal_identity_to_json(buf, term);
+    strbuf_printf(buf, ",");
+
+    strbuf_printf(
+        buf,
+        "\"parse\":{\"bytes\":%" PRIu64 ",\"ns\":%" PRIu64 ","
+        "\"throttled\":%" PRIu64 "},",
+        stats->parse.bytes, stats->parse.ns, stats->parse.throttled);
+
+    strbuf_printf(
+        buf,
+        "\"render\":{"
+        "\"frames\":%" PRIu64 ",\"deferred\":%" PRIu64 ","
+        "\"ns\":%" PRIu64 ",\"max_ns\":%" PRIu64 ","
+        "\"rows\":%" PRIu64 ",\"max_rows\":%" PRIu64 ",\"frame_times\":[",
+        stats->render.frames, stats->render.deferred,
+        stats->render.ns, stats->render.max_ns,
+        stats->render.rows, stats->render.max_rows);
+
+    for (size_t i = 0; i < TERM_STATS_FRAME_TIME_BUCKETS; i++) {
+        strbuf_printf(
+            buf, "%s%" PRIu64, i > 0 ? "," : "",
+            stats->render.frame_times[i]);
+    }
+    strbuf_printf(buf, "]},");
+
+    strbuf_printf(
+        buf, "\"scroll\":{\"shm\":%" PRIu64 ",\"memmove\":%" PRIu64 "},",
+        stats->scroll.shm, stats->scroll.memmove);
+    strbuf_printf(
+        buf, "\"damage\":{\"rects\":%" PRIu64 ",\"sent\":%" PRIu64 "},",
+        stats->damage.rects, stats->damage.sent);
+    strbuf_printf(
+        buf, "\"buffers\":{\"reused\":%" PRIu64 ",\"allocated\":%" PRIu64 "},",
+        shm->reused, shm->allocated);
+
+    strbuf_printf(
+        buf,
+        "\"app_sync_updates\":{"
+        "\"count\":%" PRIu64 ",\"timeouts\":%" PRIu64 ","
+        "\"ns\":%" PRIu64 ",\"max_ns\":%" PRIu64 ","
+        "\"bytes\":%" PRIu64 ",\"max_bytes\":%" PRIu64 ","
+        "\"timeout_ns\":%" PRIu64 "},",
+        sync->stats.count, sync->stats.timeouts,
+        sync->stats.total_ns, sync->stats.max_ns,
+        sync->stats.bytes, sync->stats.max_bytes,
+        sync->timeout_ns);
+
+    size_t scrollback_rows = 0, row_bytes = 0;
+    size_t sixel_count = 0, sixel_bytes = 0;
+    grid_memory_usage(
+        &term->normal, term->rows,
+        &scrollback_rows, &row_bytes, &sixel_count, &sixel_bytes);
+    grid_memory_usage(
+        &term->alt, term->rows,
+        &scrollback_rows, &row_bytes, &sixel_count, &sixel_bytes);
+
+    strbuf_printf(
+        buf,
+        "\"memory\":{"
+        "\"scrollback_rows\":%zu,\"row_bytes\":%zu,"
+        "\"sixel_images\":%zu,\"sixel_bytes\":%zu,"
+        "\"uris\":%zu},",
+        scrollback_rows, row_bytes, sixel_count, sixel_bytes,
+        term->uris.count);
+
+    strbuf_printf(buf, "\"composed\":%zu}", term->composed_count);
+}
+
+static char *
+terminals_to_json(const struct wayland *wayl, uint32_t id,
+                  void (*to_json)(struct strbuf *buf,
+                                  const struct terminal *term))
+{
+    struct strbuf buf = {0};
+
+    strbuf_printf(
+        &buf, "{\"version\":%d,\"terminals\":[", STATS_JSON_VERSION);
+
+    bool first = true;
+    tll_foreach(wayl->terms, it) {
+        const struct terminal *term = it->item;
+
+        if (id != 0 && term->id != id)
+            continue;
+
+        if (!first)
+            strbuf_printf(&buf, ",");
+        to_json(&buf, term);
+        first = false;
+    }
+
+    strbuf_printf(&buf, "]}\n");
+    return buf.s;
+}
+
+static void
+terminal_list_entry_to_json(struct strbuf *buf, const struct terminal *term)
+{
+    strbuf_printf(buf, "{");
+    terminal_identity_to_json(buf, term);
+    strbuf_printf(buf, "}");
+}
+
+char *
+stats_terminals_to_json(const struct wayland *wayl, uint32_t id)
+{
+    return terminals_to_json(wayl, id, &terminal_to_json);
+}
+
+char *
+stats_terminal_list_to_json(const struct wayland *wayl)
+{
+    return terminals_to_json(wayl, 0, &terminal_list_entry_to_json);
+}
+
+UNITTEST
+{
+    xassert(stats_frame_time_bucket(0) == 0);
+    xassert(stats_frame_time_bucket(249999) == 0);
+    xassert(stats_frame_time_bucket(250000) == 1);
+    xassert(stats_frame_time_bucket(1000000) == 3);
+    xassert(stats_frame_time_bucket(31999999) == 7);
+    xassert(stats_frame_time_bucket(32000000) == 8);
+    xassert(stats_frame_time_bucket(UINT64_MAX) == 8);
+
+    struct term_stats stats = {0};
+    stats_frame_rendered(&stats, 300000, 10);
+    stats_frame_rendered(&stats, 100000, 24);
+    xassert(stats.render.frames == 2);
+    xassert(stats.render.ns == 400000);
+    xassert(stats.render.max_ns == 300000);
+    xassert(stats.render.rows == 34);
+    xassert(stats.render.max_rows == 24);
+    xassert(stats.render.frame_times[0] == 1);
+    xassert(stats.render.frame_times[1] == 1);
+}
+
+UNITTEST
+{
+    struct strbuf buf = {0};
+    strbuf_json_string(&buf, "a\"b\\c\n\x01");
+    xassert(strcmp(buf.s, "\"a\\\"b\\\\c\\n\\u0001\"") == 0);
+    free(buf.s);
+
+    buf = (struct strbuf){0};
+    strbuf_json_string(&buf, NULL);
+    xassert(strcmp(buf.s, "\"\"") == 0);
+    free(buf.s);
+}
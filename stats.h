@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "terminal.h"
+#include "wayland.h"
+
+/* Version of the JSON document returned by stats_terminals_to_json() */
+#define STATS_JSON_VERSION 1
+
+size_t stats_frame_time_bucket(uint64_t ns);
+void stats_frame_rendered(struct term_stats *stats, uint64_t ns, size_t rows);
+
+/* Human readable, newline separated, summary. Used by the overlay */
+char *stats_to_text(const struct terminal *term);
+
+/* Statistics for terminal ‘id’ (or all, if 0), as a JSON document */
+char *stats_terminals_to_json(const struct wayland *wayl, uint32_t id);
+
+/* ID, PID, title etc of all terminals, as a JSON document */
+char *stats_terminal_list_to_json(const struct wayland *wayl);
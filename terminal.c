@@ -7,6 +7,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <limits.h>
 
 #include <sys/stat.h>
@@ -31,10 +32,12 @@
 #include "grid.h"
 #include "ime.h"
 #include "input.h"
+#include "misc.h"
 #include "notify.h"
 #include "quirks.h"
 #include "reaper.h"
 #include "render.h"
+#include "search.h"
 #include "selection.h"
 #include "shm.h"
 #include "sixel.h"
@@ -235,6 +238,7 @@ static struct timespec last = {0};
 #endif
 
 static bool cursor_blink_rearm_timer(struct terminal *term);
+static bool flow_control_pause(struct terminal *term);
 
 /* Externally visible, but not declared in terminal.h, to enable pgo
  * to call this function directly */
@@ -243,10 +247,16 @@ fdm_ptmx(struct fdm *fdm, int fd, int events, void *data)
 {
     struct terminal *term = data;
 
-    const bool pollin = events & EPOLLIN;
     const bool pollout = events & EPOLLOUT;
     const bool hup = events & EPOLLHUP;
 
+    /* EPOLLIN isn’t reported while paused; drain what’s left before closing */
+    const bool paused =
+        term->flow_control.paused || term->flow_control.wayl_blocked;
+    const bool pollin = (events & EPOLLIN) || (hup && paused);
+    if (unlikely(hup && term->flow_control.paused))
+        term_flow_control_resume(term);
+
     if (pollout) {
         if (!fdm_ptmx_out(fdm, fd, events, data))
             return false;
@@ -270,6 +280,8 @@ fdm_ptmx(struct fdm *fdm, int fd, int events, void *data)
 
     uint8_t buf[24 * 1024];
     const size_t max_iterations = !hup ? 10 : SIZE_MAX;
+    const uint64_t budget_ns =
+        (uint64_t)term->conf->tweak.flow_control_budget_us * 1000;
 
     for (size_t i = 0; i < max_iterations && pollin; i++) {
         xassert(pollin);
@@ -292,10 +304,40 @@ fdm_ptmx(struct fdm *fdm, int fd, int events, void *data)
         }
 
         xassert(term->interactive_resizing.grid == NULL);
+
+        struct timespec parse_start, parse_end, parse_time;
+        clock_gettime(CLOCK_MONOTONIC, &parse_start);
         vt_from_slave(term, buf, count);
+        clock_gettime(CLOCK_MONOTONIC, &parse_end);
+
+        timespec_sub(&parse_end, &parse_start, &parse_time);
+        const uint64_t parse_ns =
+            (uint64_t)parse_time.tv_sec * 1000000000 + parse_time.tv_nsec;
+
+        term->stats.parse.bytes += count;
+        term->stats.parse.ns += parse_ns;
+        term->flow_control.parse_ns += parse_ns;
+
+        if (term->render.app_sync_updates.enabled)
+            term->render.app_sync_updates.bytes += count;
+
+        if (budget_ns > 0 && !hup &&
+            term->flow_control.parse_ns >= budget_ns &&
+            flow_control_pause(term))
+        {
+            break;
+        }
     }
 
-    if (!term->render.app_sync_updates.enabled) {
+    if (unlikely(term->flow_control.paused)) {
+        /* Render what we have, right away. Reading is resumed when
+         * the frame has been presented */
+        render_refresh(term);
+    }
+
+    else if (!term->render.app_sync_updates.enabled &&
+             !term->render.app_sync_updates.flush)
+    {
         /*
          * We likely need to re-render. But, we don't want to do it
          * immediately. Often, a single client update is done through
@@ -326,7 +368,9 @@ fdm_ptmx(struct fdm *fdm, int fd, int events, void *data)
         uint64_t lower_ns = term->conf->tweak.delayed_render_lower_ns;
         uint64_t upper_ns = term->conf->tweak.delayed_render_upper_ns;
 
-        if (lower_ns > 0 && upper_ns > 0) {
+        /* Nothing will be rendered while hidden; don’t bother with
+         * the timers */
+        if (lower_ns > 0 && upper_ns > 0 && !term->render.hidden) {
 #if PTMX_TIMING
             struct timespec now;
 
@@ -372,15 +416,98 @@ fdm_ptmx(struct fdm *fdm, int fd, int events, void *data)
     return true;
 }
 
+/*
+ * Stop reading from the PTY until the next frame has been presented
+ * (see term_flow_control_resume()). Returns false if we can’t, since
+ * no frame would be rendered, in which case we just keep reading.
+ */
+static bool
+flow_control_pause(struct terminal *term)
+{
+    if (term->flow_control.paused)
+        return true;
+
+    if (term->render.app_sync_updates.enabled ||
+        term->render.hidden ||
+        !term->window->is_configured)
+    {
+        return false;
+    }
+
+    LOG_DBG("flow control: pausing PTY reads after %.2fms of parsing",
+            (double)term->flow_control.parse_ns / 1000000.);
+
+    if (!term_ptmx_pause(term))
+        return false;
+
+    term->flow_control.paused = true;
+    term->stats.parse.throttled++;
+
+    if (term->conf->tweak.flow_control_fast_forward) {
+        /*
+         * Skip the intermediate screen states; there’s no point in
+         * applying the accumulated scroll damage, when every row is
+         * going to be re-rendered anyway.
+         */
+        term->grid->scroll_damage.count = 0;
+        term_damage_view(term);
+    }
+
+    return true;
+}
+
+void
+term_flow_control_resume(struct terminal *term)
+{
+    term->flow_control.parse_ns = 0;
+
+    if (!term->flow_control.paused)
+        return;
+
+    LOG_DBG("flow control: resuming PTY reads");
+    term->flow_control.paused = false;
+
+    /* Interactive resizing has paused it too; it resumes it when done */
+    if (term->ptmx >= 0 && term->interactive_resizing.grid == NULL)
+        term_ptmx_resume(term);
+}
+
 bool
 term_ptmx_pause(struct terminal *term)
 {
     return fdm_event_del(term->fdm, term->ptmx, EPOLLIN);
 }
 
+/*
+ * Stop reading from the PTY while the Wayland socket is full. No
+ * frames are rendered until it has drained, and a flooding client
+ * would otherwise grow the grid (and scrollback) without bound. This
+ * is independent of tweak.flow-control-budget.
+ */
+void
+term_flow_control_wayl_blocked(struct terminal *term, bool blocked)
+{
+    if (blocked == term->flow_control.wayl_blocked)
+        return;
+
+    term->flow_control.wayl_blocked = blocked;
+
+    if (term->ptmx < 0)
+        return;
+
+    if (blocked)
+        term_ptmx_pause(term);
+    else if (term->interactive_resizing.grid == NULL)
+        term_ptmx_resume(term);
+}
+
+/* No-op while reads are paused by flow control, or a full Wayland socket */
 bool
 term_ptmx_resume(struct terminal *term)
 {
+    if (term->flow_control.paused || term->flow_control.wayl_blocked)
+        return true;
+
     return fdm_event_add(term->fdm, term->ptmx, EPOLLIN);
 }
 
@@ -495,14 +622,6 @@ term_arm_blink_timer(struct terminal *term)
     term->blink.fd = fd;
 }
 
-static void
-cursor_refresh(struct terminal *term)
-{
-    term->grid->cur_row->cells[term->grid->cursor.point.col].attrs.clean = 0;
-    term->grid->cur_row->dirty = true;
-    render_refresh(term);
-}
-
 static bool
 fdm_cursor_blink(struct fdm *fdm, int fd, int events, void *data)
 {
@@ -529,7 +648,7 @@ fdm_cursor_blink(struct fdm *fdm, int fd, int events, void *data)
     term->cursor_blink.state = term->cursor_blink.state == CURSOR_BLINK_ON
         ? CURSOR_BLINK_OFF : CURSOR_BLINK_ON;
 
-    cursor_refresh(term);
+    render_refresh_cursor(term);
     return true;
 }
 
@@ -580,6 +699,75 @@ fdm_delayed_render(struct fdm *fdm, int fd, int events, void *data)
     return true;
 }
 
+/*
+ * Application synchronized updates are automatically ended after a
+ * timeout. It starts out at the maximum, and then adapts to the
+ * application’s behavior; windows are allowed to stay open for a
+ * multiple of the average window duration.
+ */
+#define APP_SYNC_UPDATES_TIMEOUT_MIN_NS (100 * 1000000ull)
+#define APP_SYNC_UPDATES_TIMEOUT_MAX_NS (1000 * 1000000ull)
+#define APP_SYNC_UPDATES_TIMEOUT_FACTOR 8
+
+static void
+app_sync_updates_end(struct terminal *term, bool timed_out)
+{
+    if (!term->render.app_sync_updates.enabled)
+        return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    struct timespec diff;
+    timespec_sub(&now, &term->render.app_sync_updates.start, &diff);
+
+    const uint64_t duration_ns =
+        (uint64_t)diff.tv_sec * 1000000000 + diff.tv_nsec;
+    const size_t bytes = term->render.app_sync_updates.bytes;
+
+    uint64_t avg_ns = term->render.app_sync_updates.avg_ns;
+    avg_ns = avg_ns == 0
+        ? duration_ns
+        : avg_ns - avg_ns / 8 + duration_ns / 8;
+
+    if (timed_out) {
+        /* Back off; let the next window use the maximum timeout */
+        avg_ns = max(
+            avg_ns,
+            APP_SYNC_UPDATES_TIMEOUT_MAX_NS / APP_SYNC_UPDATES_TIMEOUT_FACTOR);
+    }
+
+    term->render.app_sync_updates.avg_ns = avg_ns;
+    term->render.app_sync_updates.timeout_ns = min(
+        max(avg_ns * APP_SYNC_UPDATES_TIMEOUT_FACTOR,
+            APP_SYNC_UPDATES_TIMEOUT_MIN_NS),
+        APP_SYNC_UPDATES_TIMEOUT_MAX_NS);
+
+    term->render.app_sync_updates.stats.count++;
+    term->render.app_sync_updates.stats.timeouts += timed_out;
+    term->render.app_sync_updates.stats.total_ns += duration_ns;
+    term->render.app_sync_updates.stats.max_ns = max(
+        term->render.app_sync_updates.stats.max_ns, duration_ns);
+    term->render.app_sync_updates.stats.bytes += bytes;
+    term->render.app_sync_updates.stats.max_bytes = max(
+        term->render.app_sync_updates.stats.max_bytes, (uint64_t)bytes);
+
+    LOG_DBG("synchronized update %s after %" PRIu64 "µs, %zu bytes "
+            "(next timeout: %" PRIu64 "ms)",
+            timed_out ? "timed out" : "ended",
+            duration_ns / 1000, bytes,
+            term->render.app_sync_updates.timeout_ns / 1000000);
+
+    term->render.app_sync_updates.enabled = false;
+    term->render.app_sync_updates.flush = true;
+    render_refresh(term);
+
+    /* Reset timers */
+    timerfd_settime(
+        term->render.app_sync_updates.timer_fd, 0,
+        &(struct itimerspec){{0}}, NULL);
+}
+
 static bool
 fdm_app_sync_updates_timeout(
     struct fdm *fdm, int fd, int events, void *data)
@@ -599,7 +787,7 @@ fdm_app_sync_updates_timeout(
         return false;
     }
 
-    term_disable_app_sync_updates(term);
+    app_sync_updates_end(term, true);
     return true;
 }
 
@@ -733,15 +921,19 @@ term_line_height_update(struct terminal *term)
 }
 
 static bool
-term_set_fonts(struct terminal *term, struct fcft_font *fonts[static 4])
+term_set_fonts(struct terminal *term, struct fcft_font *regular)
 {
-    for (size_t i = 0; i < 4; i++) {
-        xassert(fonts[i] != NULL);
+    xassert(regular != NULL);
 
+    /* Bold/italic variants are (re)loaded in the background */
+    for (size_t i = 0; i < 4; i++) {
         fcft_destroy(term->fonts[i]);
-        term->fonts[i] = fonts[i];
+        term->fonts[i] = NULL;
     }
 
+    term->fonts[0] = regular;
+    term->font_generation++;
+
     free_custom_glyphs(
         &term->custom_glyphs.box_drawing, GLYPH_BOX_DRAWING_COUNT);
     free_custom_glyphs(
@@ -752,7 +944,7 @@ term_set_fonts(struct terminal *term, struct fcft_font *fonts[static 4])
     const struct config *conf = term->conf;
 
     const struct fcft_glyph *M = fcft_rasterize_char_utf32(
-        fonts[0], U'M', term->font_subpixel);
+        regular, U'M', term->font_subpixel);
     int advance = M != NULL ? M->advance.x : term->fonts[0]->max_advance.x;
 
     term_line_height_update(term);
@@ -892,6 +1084,27 @@ struct font_load_data {
     const char *attrs;
 
     struct fcft_font **font;
+    int event_fd;
+};
+
+/*
+ * Loads the bold, italic and bold+italic fonts in the background,
+ * since many sessions never use them. Until done, the regular font
+ * is used as a stand-in.
+ */
+struct font_variant_loader {
+    int event_fd;
+    size_t pending;             /* Threads that haven’t yet finished */
+
+    thrd_t tids[3];
+    struct font_load_data data[3];
+    struct fcft_font *fonts[3];
+
+    /* Font names and attributes; owned by us, since the loader
+     * threads reference them */
+    size_t counts[4];
+    char **names[4];
+    char *attrs[4];
 };
 
 static int
@@ -899,23 +1112,128 @@ font_loader_thread(void *_data)
 {
     struct font_load_data *data = _data;
     *data->font = fcft_from_name(data->count, data->names, data->attrs);
+
+    if (data->event_fd >= 0 &&
+        write(data->event_fd, &(uint64_t){1}, sizeof(uint64_t)) != sizeof(uint64_t))
+    {
+        LOG_ERRNO("failed to signal font loader completion");
+    }
+
     return *data->font != NULL;
 }
 
+static void
+font_variant_loader_free(struct terminal *term, struct font_variant_loader *loader)
+{
+    if (loader == NULL)
+        return;
+
+    for (size_t i = 0; i < 3; i++) {
+        if (loader->tids[i] != 0)
+            thrd_join(loader->tids[i], NULL);
+        fcft_destroy(loader->fonts[i]);
+    }
+
+    fdm_del(term->fdm, loader->event_fd);
+
+    for (size_t i = 0; i < 4; i++) {
+        for (size_t j = 0; j < loader->counts[i]; j++)
+            free(loader->names[i][j]);
+        free(loader->names[i]);
+        free(loader->attrs[i]);
+    }
+
+    free(loader);
+}
+
+/* Joins (waits for) outstanding loader threads, and discards their fonts */
+static void
+font_variants_cancel(struct terminal *term)
+{
+    font_variant_loader_free(term, term->font_variant_loader);
+    term->font_variant_loader = NULL;
+}
+
+static void
+font_variants_install(struct terminal *term)
+{
+    struct font_variant_loader *loader = term->font_variant_loader;
+    static const char *const names[] = {"bold", "italic", "bold italic"};
+
+    for (size_t i = 0; i < 3; i++) {
+        if (loader->tids[i] != 0) {
+            thrd_join(loader->tids[i], NULL);
+            loader->tids[i] = 0;
+        }
+
+        if (loader->fonts[i] == NULL) {
+            LOG_WARN("failed to load %s font, using the regular font instead",
+                     names[i]);
+            continue;
+        }
+
+        xassert(term->fonts[1 + i] == NULL);
+        term->fonts[1 + i] = loader->fonts[i];
+        loader->fonts[i] = NULL;
+    }
+
+    font_variants_cancel(term);
+
+    /* Re-render cells that were rendered using the stand-in font */
+    if (term->rows > 0) {
+        term_damage_view(term);
+        render_refresh(term);
+    }
+}
+
+static bool
+fdm_font_variants_loaded(struct fdm *fdm, int fd, int events, void *data)
+{
+    struct terminal *term = data;
+    struct font_variant_loader *loader = term->font_variant_loader;
+
+    if (events & EPOLLHUP)
+        return false;
+
+    uint64_t count;
+    if (read(fd, &count, sizeof(count)) < 0) {
+        if (errno == EAGAIN)
+            return true;
+
+        LOG_ERRNO("failed to read font loader event FD");
+        return false;
+    }
+
+    xassert(loader != NULL);
+    xassert(loader->event_fd == fd);
+    xassert(count <= loader->pending);
+
+    loader->pending -= count;
+    if (loader->pending == 0)
+        font_variants_install(term);
+
+    return true;
+}
+
 static bool
 reload_fonts(struct terminal *term)
 {
     const struct config *conf = term->conf;
 
-    const size_t counts[4] = {
-        conf->fonts[0].count,
-        conf->fonts[1].count,
-        conf->fonts[2].count,
-        conf->fonts[3].count,
-    };
+    /* Variants of the previous font size are useless */
+    font_variants_cancel(term);
+
+    struct font_variant_loader *loader = xcalloc(1, sizeof(*loader));
+    loader->event_fd = -1;
+
+    size_t *counts = loader->counts;
+    char ***names = loader->names;
+    char **attrs = loader->attrs;
+
+    for (size_t i = 0; i < 4; i++)
+        counts[i] = conf->fonts[i].count;
 
     /* Configure size (which may have been changed run-time) */
-    char **names[4];
     for (size_t i = 0; i < 4; i++) {
         names[i] = xmalloc(counts[i] * sizeof(names[i][0]));
 
@@ -963,7 +1281,6 @@ reload_fonts(struct terminal *term)
 
     const bool use_dpi = term->font_is_sized_by_dpi;
 
-    char *attrs[4] = {NULL};
     int attr_len[4] = {-1, -1, -1, -1};  /* -1, so that +1 (below) results in 0 */
 
     for (size_t i = 0; i < 2; i++) {
@@ -987,50 +1304,72 @@ reload_fonts(struct terminal *term)
             attrs[i] = xmalloc(attr_len[i] + 1);
     }
 
-    struct fcft_font *fonts[4];
-    struct font_load_data data[4] = {
-        {count_regular,     names_regular,     attrs[0], &fonts[0]},
-        {count_bold,        names_bold,        attrs[1], &fonts[1]},
-        {count_italic,      names_italic,      attrs[2], &fonts[2]},
-        {count_bold_italic, names_bold_italic, attrs[3], &fonts[3]},
+    /* Only the regular font is needed to render the first frame */
+    struct fcft_font *regular = fcft_from_name(
+        count_regular, names_regular, attrs[0]);
+
+    if (regular == NULL) {
+        LOG_ERR("failed to load primary fonts");
+        font_variant_loader_free(term, loader);
+        return false;
+    }
+
+    const struct {
+        size_t count;
+        const char **names;
+    } variants[3] = {
+        {count_bold,        names_bold},
+        {count_italic,      names_italic},
+        {count_bold_italic, names_bold_italic},
     };
 
-    thrd_t tids[4] = {0};
-    for (size_t i = 0; i < 4; i++) {
-        int ret = thrd_create(&tids[i], &font_loader_thread, &data[i]);
-        if (ret != thrd_success) {
+    int event_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (event_fd < 0)
+        LOG_ERRNO("failed to create font loader event FD");
+    else if (!fdm_add(term->fdm, event_fd, EPOLLIN, &fdm_font_variants_loaded, term)) {
+        close(event_fd);
+        event_fd = -1;
+    }
+
+    loader->event_fd = event_fd;
+
+    for (size_t i = 0; i < 3; i++) {
+        loader->data[i] = (struct font_load_data){
+            .count = variants[i].count,
+            .names = variants[i].names,
+            .attrs = attrs[1 + i],
+            .font = &loader->fonts[i],
+            .event_fd = event_fd,
+        };
+
+        if (event_fd >= 0) {
+            int ret = thrd_create(
+                &loader->tids[i], &font_loader_thread, &loader->data[i]);
+
+            if (ret == thrd_success) {
+                loader->pending++;
+                continue;
+            }
+
             LOG_ERR("failed to create font loader thread: %s (%d)",
                     thrd_err_as_string(ret), ret);
-            break;
+            loader->tids[i] = 0;
         }
-    }
 
-    bool success = true;
-    for (size_t i = 0; i < 4; i++) {
-        if (tids[i] != 0) {
-            int ret;
-            thrd_join(tids[i], &ret);
-            success = success && ret;
-        } else
-            success = false;
+        /* Fallback: load synchronously */
+        loader->data[i].event_fd = -1;
+        font_loader_thread(&loader->data[i]);
     }
 
-    for (size_t i = 0; i < 4; i++) {
-        for (size_t j = 0; j < counts[i]; j++)
-            free(names[i][j]);
-        free(names[i]);
-        free(attrs[i]);
-    }
+    term->font_variant_loader = loader;
 
-    if (!success) {
-        LOG_ERR("failed to load primary fonts");
-        for (size_t i = 0; i < 4; i++) {
-            fcft_destroy(fonts[i]);
-            fonts[i] = NULL;
-        }
-    }
+    if (!term_set_fonts(term, regular))
+        return false;
+
+    if (loader->pending == 0)
+        font_variants_install(term);
 
-    return success ? term_set_fonts(term, fonts) : success;
+    return true;
 }
 
 static bool
@@ -1135,8 +1474,11 @@ term_init(const struct config *conf, struct fdm *fdm, struct reaper *reaper,
         goto err;
     }
 
+    static uint32_t next_id = 1;
+
     /* Initialize configure-based terminal attributes */
     *term = (struct terminal) {
+        .id = next_id++,
         .fdm = fdm,
         .reaper = reaper,
         .conf = conf,
@@ -1197,8 +1539,8 @@ term_init(const struct config *conf, struct fdm *fdm, struct reaper *reaper,
                 .fd = -1,
             },
         },
-        .normal = {.scroll_damage = tll_init(), .sixel_images = tll_init()},
-        .alt = {.scroll_damage = tll_init(), .sixel_images = tll_init()},
+        .normal = {.sixel_images = tll_init()},
+        .alt = {.sixel_images = tll_init()},
         .grid = &term->normal,
         .composed = NULL,
         .alt_scrolling = conf->mouse.alternate_scroll_mode,
@@ -1216,12 +1558,17 @@ term_init(const struct config *conf, struct fdm *fdm, struct reaper *reaper,
                 .search = shm_chain_new(wayl->shm, false, 1),
                 .scrollback_indicator = shm_chain_new(wayl->shm, false, 1),
                 .render_timer = shm_chain_new(wayl->shm, false, 1),
+                .stats = shm_chain_new(wayl->shm, false, 1),
                 .url = shm_chain_new(wayl->shm, false, 1),
                 .csd = shm_chain_new(wayl->shm, false, 1),
                 .overlay = shm_chain_new(wayl->shm, false, 1),
+                .cursor = shm_chain_new(wayl->shm, false, 1),
             },
             .scrollback_lines = conf->scrollback.lines,
-            .app_sync_updates.timer_fd = app_sync_updates_fd,
+            .app_sync_updates = {
+                .timer_fd = app_sync_updates_fd,
+                .timeout_ns = APP_SYNC_UPDATES_TIMEOUT_MAX_NS,
+            },
             .title = {
                 .is_armed = false,
                 .timer_fd = title_update_fd,
@@ -1230,6 +1577,11 @@ term_init(const struct config *conf, struct fdm *fdm, struct reaper *reaper,
                 .count = conf->render_worker_count,
                 .queue = tll_init(),
             },
+            .sixel_scaler = {
+                .event_fd = -1,
+                .queue = tll_init(),
+                .done = tll_init(),
+            },
         },
         .delayed_render_timer = {
             .is_armed = false,
@@ -1255,9 +1607,8 @@ term_init(const struct config *conf, struct fdm *fdm, struct reaper *reaper,
 #endif
     };
 
-    pixman_region32_init(&term->render.last_overlay_clip);
-
     term_update_ascii_printer(term);
+    pixman_region32_init(&term->render.damage);
 
     for (size_t i = 0; i < 4; i++) {
         const struct config_font_list *font_list = &conf->fonts[i];
@@ -1657,13 +2008,15 @@ term_destroy(struct terminal *term)
     urls_reset(term);
 
     free(term->vt.osc.data);
-    free(term->vt.osc8.uri);
+    free(term->vt.osc.clip.data);
+    grid_uri_unref(term->vt.osc8.uri);
 
     composed_free(term->composed);
 
     free(term->window_title);
     tll_free_and_free(term->window_title_stack, free);
 
+    font_variants_cancel(term);
     for (size_t i = 0; i < sizeof(term->fonts) / sizeof(term->fonts[0]); i++)
         fcft_destroy(term->fonts[i]);
     for (size_t i = 0; i < 4; i++)
@@ -1679,6 +2032,7 @@ term_destroy(struct terminal *term)
 
     free(term->search.buf);
     free(term->search.last.buf);
+    search_matches_cache_destroy(term);
 
     if (term->render.workers.threads != NULL) {
         for (size_t i = 0; i < term->render.workers.count; i++) {
@@ -1693,15 +2047,27 @@ term_destroy(struct terminal *term)
     xassert(tll_length(term->render.workers.queue) == 0);
     tll_free(term->render.workers.queue);
 
+    render_sixel_scaler_destroy(term);
+    render_normal_screen_destroy(term);
+
     shm_unref(term->render.last_buf);
     shm_chain_free(term->render.chains.grid);
     shm_chain_free(term->render.chains.search);
     shm_chain_free(term->render.chains.scrollback_indicator);
     shm_chain_free(term->render.chains.render_timer);
+    shm_chain_free(term->render.chains.stats);
     shm_chain_free(term->render.chains.url);
     shm_chain_free(term->render.chains.csd);
     shm_chain_free(term->render.chains.overlay);
-    pixman_region32_fini(&term->render.last_overlay_clip);
+    shm_chain_free(term->render.chains.cursor);
+
+    for (int i = 0; i < term->render.last_overlay_matches.count; i++) {
+        free(term->render.last_overlay_matches.rows[i].v);
+        free(term->render.last_overlay_matches.next[i].v);
+    }
+    free(term->render.last_overlay_matches.rows);
+    free(term->render.last_overlay_matches.next);
+    pixman_region32_fini(&term->render.damage);
 
     tll_free(term->tab_stops);
 
@@ -1722,6 +2088,7 @@ term_destroy(struct terminal *term)
     grid_free(&term->alt);
     grid_free(term->interactive_resizing.grid);
     free(term->interactive_resizing.grid);
+    grid_uri_table_destroy(&term->uris);
 
     free(term->foot_exe);
     free(term->cwd);
@@ -1823,14 +2190,18 @@ erase_cell_range(struct terminal *term, struct row *row, int start, int end)
     const enum color_source bg_src = term->vt.attrs.bg_src;
 
     if (unlikely(bg_src != COLOR_DEFAULT)) {
-        for (int col = start; col <= end; col++) {
-            struct cell *c = &row->cells[col];
-            c->wc = 0;
-            c->attrs = (struct attributes){.bg_src = bg_src, .bg = term->vt.attrs.bg};
-        }
+        grid_cells_fill(
+            &row->cells[start],
+            (struct cell){
+                .attrs = {.bg_src = bg_src, .bg = term->vt.attrs.bg}},
+            end - start + 1);
     } else
         memset(&row->cells[start], 0, (end - start + 1) * sizeof(row->cells[0]));
 
+    /* Everything from ‘start’ is now empty, if we erased up to the used width */
+    if (end + 1 >= row->used)
+        row->used = min(row->used, start);
+
     if (unlikely(row->extra != NULL))
         grid_row_uri_range_erase(row, start, end);
 }
@@ -1878,8 +2249,9 @@ term_reset(struct terminal *term, bool hard)
     term->scroll_region.start = 0;
     term->scroll_region.end = term->rows;
 
-    free(term->vt.osc8.uri);
+    grid_uri_unref(term->vt.osc8.uri);
     free(term->vt.osc.data);
+    free(term->vt.osc.clip.data);
 
     term->vt = (struct vt){
         .state = 0,     /* STATE_GROUND */
@@ -1888,6 +2260,7 @@ term_reset(struct terminal *term, bool hard)
     if (term->grid == &term->alt) {
         term->grid = &term->normal;
         selection_cancel(term);
+        render_alt_screen_exited(term);
     }
 
     term->meta.esc_prefix = true;
@@ -1901,6 +2274,8 @@ term_reset(struct terminal *term, bool hard)
         sixel_destroy(&it->item);
         tll_remove(term->alt.sixel_images, it);
     }
+    sixel_index_invalidate(&term->normal);
+    sixel_index_invalidate(&term->alt);
 
 #if defined(FOOT_IME_ENABLED) && FOOT_IME_ENABLED
     term_ime_enable(term);
@@ -1956,8 +2331,7 @@ term_reset(struct terminal *term, bool hard)
     }
     term->normal.cur_row = term->normal.rows[0];
     term->alt.cur_row = term->alt.rows[0];
-    tll_free(term->normal.scroll_damage);
-    tll_free(term->alt.scroll_damage);
+    term->normal.scroll_damage.count = term->alt.scroll_damage.count = 0;
     term->render.last_cursor.row = NULL;
     term_damage_all(term);
 
@@ -2186,32 +2560,141 @@ term_damage_margins(struct terminal *term)
     term->render.margins = true;
 }
 
+static inline bool
+damage_is_in_view(enum damage_type type)
+{
+    return type == DAMAGE_SCROLL_IN_VIEW ||
+           type == DAMAGE_SCROLL_REVERSE_IN_VIEW;
+}
+
+static inline bool
+damage_is_reverse(enum damage_type type)
+{
+    return type == DAMAGE_SCROLL_REVERSE ||
+           type == DAMAGE_SCROLL_REVERSE_IN_VIEW;
+}
+
 void
 term_damage_scroll(struct terminal *term, enum damage_type damage_type,
                    struct scroll_region region, int lines)
 {
-    if (likely(tll_length(term->grid->scroll_damage) > 0)) {
-        struct damage *dmg = &tll_back(term->grid->scroll_damage);
+    struct grid *grid = term->grid;
+    struct damage *damage = grid->scroll_damage.v;
+    size_t *count = &grid->scroll_damage.count;
+
+    const bool in_view = damage_is_in_view(damage_type);
+
+    /*
+     * Scrolling by the region’s height, or more, replaces the entire
+     * region. Saturate there, to avoid overflowing when lots of
+     * scrolls are folded without being rendered.
+     */
+    const int height = region.end - region.start;
+    lines = min(lines, height);
 
-        if (likely(
-                dmg->type == damage_type &&
-                dmg->region.start == region.start &&
-                dmg->region.end == region.end))
+    /*
+     * Fold into an earlier entry for the same region, as long as no
+     * entry in between touches the region (the order in which
+     * disjoint regions are scrolled doesn’t matter).
+     *
+     * The entry’s net displacement is what matters; any row scrolled
+     * in along the way has been erased, and is thus dirty, and will
+     * be re-rendered regardless. This means scrolls in opposite
+     * directions cancel each other out.
+     */
+    for (size_t i = *count; i > 0; i--) {
+        struct damage *dmg = &damage[i - 1];
+
+        if (dmg->region.start == region.start &&
+            dmg->region.end == region.end &&
+            damage_is_in_view(dmg->type) == in_view)
         {
-            /* Make sure we don’t overflow... */
-            int new_line_count = (int)dmg->lines + lines;
-            if (likely(new_line_count <= UINT16_MAX)) {
-                dmg->lines = new_line_count;
-                return;
+            const int net = max(-height, min(
+                (damage_is_reverse(dmg->type) ? -dmg->lines : dmg->lines) +
+                (damage_is_reverse(damage_type) ? -lines : lines),
+                height));
+
+            if (net == 0) {
+                memmove(dmg, dmg + 1, (*count - i) * sizeof(*dmg));
+                (*count)--;
+            } else if (net > 0) {
+                dmg->type = in_view ? DAMAGE_SCROLL_IN_VIEW : DAMAGE_SCROLL;
+                dmg->lines = net;
+            } else {
+                dmg->type = in_view
+                    ? DAMAGE_SCROLL_REVERSE_IN_VIEW : DAMAGE_SCROLL_REVERSE;
+                dmg->lines = -net;
             }
+            return;
         }
+
+        if (dmg->region.start < region.end && region.start < dmg->region.end)
+            break;
+    }
+
+    if (unlikely(*count >= ALEN(grid->scroll_damage.v))) {
+        /* Too many regions; re-render everything instead */
+        *count = 0;
+        term_damage_view(term);
+        return;
     }
-    struct damage dmg = {
+
+    damage[(*count)++] = (struct damage){
         .type = damage_type,
         .region = region,
         .lines = lines,
     };
-    tll_push_back(term->grid->scroll_damage, dmg);
+}
+
+UNITTEST
+{
+    struct terminal term = {.grid = &term.normal};
+    struct grid *grid = &term.normal;
+    const struct scroll_region full = {0, 10};
+    const struct scroll_region top = {0, 5};
+    const struct scroll_region bottom = {6, 10};
+
+    /* Opposite scrolls cancel out */
+    term_damage_scroll(&term, DAMAGE_SCROLL, full, 3);
+    term_damage_scroll(&term, DAMAGE_SCROLL_REVERSE, full, 1);
+    xassert(grid->scroll_damage.count == 1);
+    xassert(grid->scroll_damage.v[0].type == DAMAGE_SCROLL);
+    xassert(grid->scroll_damage.v[0].lines == 2);
+
+    term_damage_scroll(&term, DAMAGE_SCROLL_REVERSE, full, 5);
+    xassert(grid->scroll_damage.count == 1);
+    xassert(grid->scroll_damage.v[0].type == DAMAGE_SCROLL_REVERSE);
+    xassert(grid->scroll_damage.v[0].lines == 3);
+
+    term_damage_scroll(&term, DAMAGE_SCROLL, full, 3);
+    xassert(grid->scroll_damage.count == 0);
+
+    /* Folding across a disjoint region */
+    term_damage_scroll(&term, DAMAGE_SCROLL, top, 1);
+    term_damage_scroll(&term, DAMAGE_SCROLL_REVERSE, bottom, 1);
+    term_damage_scroll(&term, DAMAGE_SCROLL, top, 1);
+    xassert(grid->scroll_damage.count == 2);
+    xassert(grid->scroll_damage.v[0].lines == 2);
+    xassert(grid->scroll_damage.v[1].type == DAMAGE_SCROLL_REVERSE);
+
+    /* ... but not across an overlapping one */
+    term_damage_scroll(&term, DAMAGE_SCROLL, full, 1);
+    term_damage_scroll(&term, DAMAGE_SCROLL, top, 1);
+    xassert(grid->scroll_damage.count == 4);
+    xassert(grid->scroll_damage.v[0].lines == 2);
+    xassert(grid->scroll_damage.v[3].lines == 1);
+
+    /* View scrolling is kept separate */
+    term_damage_scroll(&term, DAMAGE_SCROLL_REVERSE_IN_VIEW, top, 1);
+    xassert(grid->scroll_damage.count == 5);
+    xassert(grid->scroll_damage.v[3].lines == 1);
+
+    /* Saturates at the region’s height */
+    grid->scroll_damage.count = 0;
+    term_damage_scroll(&term, DAMAGE_SCROLL, full, INT_MAX);
+    term_damage_scroll(&term, DAMAGE_SCROLL, full, INT_MAX);
+    xassert(grid->scroll_damage.count == 1);
+    xassert(grid->scroll_damage.v[0].lines == 10);
 }
 
 void
@@ -2243,15 +2726,23 @@ term_erase(struct terminal *term, int start_row, int start_col,
     sixel_overwrite_by_row(term, end_row, 0, end_col + 1);
 }
 
-void
-term_erase_scrollback(struct terminal *term)
+/*
+ * Frees all but the ‘keep’ most recent scrollback rows of ‘grid’.
+ * Returns the number of freed rows.
+ */
+static size_t
+scrollback_trim(struct terminal *term, struct grid *grid, int keep)
 {
-    const struct grid *grid = term->grid;
     const int num_rows = grid->num_rows;
     const int mask = num_rows - 1;
 
+    if (keep < 0)
+        keep = 0;
+    if (keep >= num_rows - term->rows)
+        return 0;
+
     const int start = (grid->offset + term->rows) & mask;
-    const int end = (grid->offset - 1) & mask;
+    const int end = (grid->offset - 1 - keep) & mask;
 
     const int rel_start = grid_row_abs_to_sb(grid, term->rows, start);
     const int rel_end = grid_row_abs_to_sb(grid, term->rows, end);
@@ -2259,7 +2750,7 @@ term_erase_scrollback(struct terminal *term)
     const int sel_start = selection_get_start(term).row;
     const int sel_end = selection_get_end(term).row;
 
-    if (sel_end >= 0) {
+    if (grid == term->grid && sel_end >= 0) {
         /*
          * Cancel selection if it touches any of the rows in the
          * scrollback, since we can’t have the selection reference
@@ -2286,7 +2777,7 @@ term_erase_scrollback(struct terminal *term)
         }
     }
 
-    tll_foreach(term->grid->sixel_images, it) {
+    tll_foreach(grid->sixel_images, it) {
         struct sixel *six = &it->item;
         const int six_start = grid_row_abs_to_sb(grid, term->rows, six->pos.row);
         const int six_end = grid_row_abs_to_sb(
@@ -2297,28 +2788,108 @@ term_erase_scrollback(struct terminal *term)
             (six_start >= rel_start && six_end <= rel_end))
         {
             sixel_destroy(six);
-            tll_remove(term->grid->sixel_images, it);
+            tll_remove(grid->sixel_images, it);
+            sixel_index_invalidate(grid);
         }
     }
 
+    size_t freed = 0;
     for (int i = start;; i = (i + 1) & mask) {
-        struct row *row = term->grid->rows[i];
+        struct row *row = grid->rows[i];
         if (row != NULL) {
             if (term->render.last_cursor.row == row)
                 term->render.last_cursor.row = NULL;
 
             grid_row_free(row);
-            term->grid->rows[i] = NULL;
+            grid->rows[i] = NULL;
+            freed++;
         }
 
         if (i == end)
             break;
     }
 
+    /* Reset the viewport if it refers to any of the freed rows */
+    if (grid_row_abs_to_sb(grid, term->rows, grid->view) <= rel_end) {
+        grid->view = grid->offset;
+        if (grid == term->grid)
+            term_damage_view(term);
+    }
+
+    return freed;
+}
+
+void
+term_erase_scrollback(struct terminal *term)
+{
+    scrollback_trim(term, term->grid, 0);
     term->grid->view = term->grid->offset;
     term_damage_view(term);
 }
 
+/*
+ * Frees all but the ‘keep’ most recent rows of the (normal grid’s)
+ * scrollback, regardless of which grid is currently active.
+ */
+size_t
+term_scrollback_trim(struct terminal *term, int keep)
+{
+    size_t freed = scrollback_trim(term, &term->normal, keep);
+    if (freed > 0)
+        render_refresh(term);
+    return freed;
+}
+
+/*
+ * Releases memory held by rows, but no longer used (e.g. OSC-8 URI
+ * range arrays left empty after the URIs have been erased), and
+ * then returns free heap memory to the OS.
+ *
+ * Returns the number of compacted rows.
+ */
+size_t
+term_compact(struct terminal *term)
+{
+    size_t compacted = 0;
+
+    struct grid *grids[] = {&term->normal, &term->alt};
+    for (size_t i = 0; i < ALEN(grids); i++) {
+        struct grid *grid = grids[i];
+
+        for (int r = 0; r < grid->num_rows; r++) {
+            if (grid->rows[r] != NULL && grid_row_compact(grid->rows[r]))
+                compacted++;
+        }
+    }
+
+#if defined(__GLIBC__)
+    if (!malloc_trim(0))
+        LOG_DBG("malloc_trim() did not release any memory");
+#endif
+
+    return compacted;
+}
+
+/*
+ * Drops cached data that can be re-created on demand: our
+ * custom-rendered (box drawing, braille and legacy computing) glyphs,
+ * and rescaled copies of sixel images.
+ *
+ * Returns the number of freed sixel bytes.
+ */
+size_t
+term_drop_caches(struct terminal *term)
+{
+    free_custom_glyphs(
+        &term->custom_glyphs.box_drawing, GLYPH_BOX_DRAWING_COUNT);
+    free_custom_glyphs(
+        &term->custom_glyphs.braille, GLYPH_BRAILLE_COUNT);
+    free_custom_glyphs(
+        &term->custom_glyphs.legacy, GLYPH_LEGACY_COUNT);
+
+    return sixel_drop_caches(term);
+}
+
 UNITTEST
 {
     const int scrollback_rows = 16;
@@ -2438,6 +3009,28 @@ UNITTEST
     populate_scrollback();
     term_erase_scrollback(&term);
     xassert(tll_length(term.normal.sixel_images) == 1);
+    tll_free(term.normal.sixel_images);
+
+    /*
+     * Test case 6 - partial trim, keeping the three most recent
+     * scrollback rows
+     */
+    term.normal.offset = 11;  /* Screen covers rows 11-15 */
+    term.normal.view = 1;     /* Viewport covers rows 1-5 */
+    populate_scrollback();
+
+    xassert(scrollback_trim(&term, &term.normal, 3) == 8);
+    for (int i = 0; i < scrollback_rows; i++) {
+        if (i >= 8)
+            xassert(term.normal.rows[i] != NULL);
+        else
+            xassert(term.normal.rows[i] == NULL);
+    }
+    xassert(term.normal.view == term.normal.offset);
+
+    /* Nothing left to trim */
+    xassert(scrollback_trim(&term, &term.normal, 3) == 0);
+    xassert(scrollback_trim(&term, &term.normal, 100) == 0);
 
     /* Cleanup */
     tll_free(term.normal.sixel_images);
@@ -2575,7 +3168,8 @@ void
 term_cursor_blink_update(struct terminal *term)
 {
     bool enable = term->cursor_blink.decset || term->cursor_blink.deccsusr;
-    bool activate = !term->shutdown.in_progress && enable && term->visual_focus;
+    bool activate = !term->shutdown.in_progress && enable &&
+        term->visual_focus && !term->render.hidden;
 
     LOG_DBG("decset=%d, deccsrusr=%d, focus=%d, shutting-down=%d, enable=%d, activate=%d",
             term->cursor_blink.decset, term->cursor_blink.deccsusr,
@@ -2589,6 +3183,41 @@ term_cursor_blink_update(struct terminal *term)
         cursor_blink_disarm_timer(term);
 }
 
+void
+term_visibility_update(struct terminal *term)
+{
+    const bool hidden =
+        term->window->is_suspended || term->render.frame_starved;
+
+    if (hidden == term->render.hidden)
+        return;
+
+    LOG_DBG("window is now %s (suspended=%d, frame-starved=%d)",
+            hidden ? "hidden" : "visible",
+            term->window->is_suspended, term->render.frame_starved);
+
+    term->render.hidden = hidden;
+    term_cursor_blink_update(term);
+
+    if (hidden) {
+        /* No frames will be presented */
+        term_flow_control_resume(term);
+
+        /* Re-armed by the renderer, if there still are blinking cells */
+        term->blink.state = BLINK_ON;
+        fdm_del(term->fdm, term->blink.fd);
+        term->blink.fd = -1;
+    } else {
+        /* Repaint everything */
+        term_damage_view(term);
+        render_refresh(term);
+        render_refresh_csd(term);
+
+        /* Flush rate limited title updates */
+        render_refresh_title(term);
+    }
+}
+
 static bool
 selection_on_top_region(const struct terminal *term,
                         struct scroll_region region)
@@ -2853,7 +3482,7 @@ term_kbd_focus_in(struct terminal *term)
         term_damage_margins(term);
     }
 
-    cursor_refresh(term);
+    render_refresh_cursor(term);
 
     if (term->focus_events)
         term_to_slave(term, "\033[I", 3);
@@ -2875,7 +3504,7 @@ term_kbd_focus_out(struct terminal *term)
 #endif
 
     term->kbd_focus = false;
-    cursor_refresh(term);
+    render_refresh_cursor(term);
 
     if (term->focus_events)
         term_to_slave(term, "\033[O", 3);
@@ -3257,11 +3886,24 @@ term_spawn_new(const struct terminal *term)
 void
 term_enable_app_sync_updates(struct terminal *term)
 {
+    if (!term->render.app_sync_updates.enabled) {
+        clock_gettime(CLOCK_MONOTONIC, &term->render.app_sync_updates.start);
+        term->render.app_sync_updates.bytes = 0;
+    }
+
     term->render.app_sync_updates.enabled = true;
+    term->render.app_sync_updates.flush = false;
+
+    const uint64_t timeout_ns = term->render.app_sync_updates.timeout_ns;
+    const struct itimerspec timeout = {
+        .it_value = {
+            .tv_sec = timeout_ns / 1000000000,
+            .tv_nsec = timeout_ns % 1000000000,
+        },
+    };
 
     if (timerfd_settime(
-            term->render.app_sync_updates.timer_fd, 0,
-            &(struct itimerspec){.it_value = {.tv_sec = 1}}, NULL) < 0)
+            term->render.app_sync_updates.timer_fd, 0, &timeout, NULL) < 0)
     {
         LOG_ERR("failed to arm timer for application synchronized updates");
     }
@@ -3288,16 +3930,7 @@ term_enable_app_sync_updates(struct terminal *term)
 void
 term_disable_app_sync_updates(struct terminal *term)
 {
-    if (!term->render.app_sync_updates.enabled)
-        return;
-
-    term->render.app_sync_updates.enabled = false;
-    render_refresh(term);
-
-    /* Reset timers */
-    timerfd_settime(
-        term->render.app_sync_updates.timer_fd, 0,
-        &(struct itimerspec){{0}}, NULL);
+    app_sync_updates_end(term, false);
 }
 
 static inline void
@@ -3344,6 +3977,7 @@ print_insert(struct terminal *term, int width)
         &row->cells[term->grid->cursor.point.col + width],
         &row->cells[term->grid->cursor.point.col],
         move_count * sizeof(struct cell));
+    row->used = min(row->used + width, term->cols);
 
     /* Mark moved cells as dirty */
     for (size_t i = term->grid->cursor.point.col + width; i < term->cols; i++)
@@ -3359,6 +3993,7 @@ print_spacer(struct terminal *term, int col, int remaining)
 
     cell->wc = CELL_SPACER + remaining;
     cell->attrs = term->vt.attrs;
+    grid_row_mark_used(row, col + 1);
 }
 
 void
@@ -3414,8 +4049,7 @@ term_print(struct terminal *term, char32_t wc, int width)
     cell->attrs = term->vt.attrs;
 
     if (term->vt.osc8.uri != NULL) {
-        grid_row_uri_range_put(
-            row, col, term->vt.osc8.uri, term->vt.osc8.id);
+        grid_row_uri_range_put(row, col, term->vt.osc8.uri);
 
         switch (term->conf->url.osc8_underline) {
         case OSC8_UNDERLINE_ALWAYS:
@@ -3434,6 +4068,8 @@ term_print(struct terminal *term, char32_t wc, int width)
         print_spacer(term, col, width - i);
     }
 
+    grid_row_mark_used(row, col + 1);
+
     /* Advance cursor */
     if (unlikely(++col >= term->cols)) {
         grid->cursor.lcf = true;
@@ -3457,10 +4093,15 @@ ascii_printer_fast(struct terminal *term, char32_t wc)
 
     xassert(term->charsets.set[term->charsets.selected] == CHARSET_ASCII);
     xassert(!term->insert_mode);
-    xassert(tll_length(grid->sixel_images) == 0);
 
     print_linewrap(term);
 
+    if (unlikely(sixel_row_has_images(grid, grid->cursor.point.row))) {
+        /* Printing on top of an image - needs to be erased */
+        term_print(term, wc, 1);
+        return;
+    }
+
     /* *Must* get current cell *after* linewrap+insert */
     int col = grid->cursor.point.col;
     const int uri_start = col;
@@ -3472,6 +4113,7 @@ ascii_printer_fast(struct terminal *term, char32_t wc)
     struct cell *cell = &row->cells[col];
     cell->wc = term->vt.last_printed = wc;
     cell->attrs = term->vt.attrs;
+    grid_row_mark_used(row, col + 1);
 
     /* Advance cursor */
     if (unlikely(++col >= term->cols)) {
@@ -3498,8 +4140,7 @@ void
 term_update_ascii_printer(struct terminal *term)
 {
     void (*new_printer)(struct terminal *term, char32_t wc) =
-        unlikely(tll_length(term->grid->sixel_images) > 0 ||
-                 term->vt.osc8.uri != NULL ||
+        unlikely(term->vt.osc8.uri != NULL ||
                  term->charsets.set[term->charsets.selected] == CHARSET_GRAPHIC ||
                  term->insert_mode)
         ? &ascii_printer_generic
@@ -3564,10 +4205,18 @@ rows_to_text(const struct terminal *term, int start, int end,
         const struct row *row = term->grid->rows[r];
         xassert(row != NULL);
 
-        for (int c = 0; c < term->cols; c++)
+        const int used = min(row->used, term->cols);
+
+        for (int c = 0; c < used; c++)
             if (!extract_one(term, row, &row->cells[c], c, ctx))
                 goto out;
 
+        if (used < term->cols &&
+            !extract_empty(term, row, used, term->cols - used, ctx))
+        {
+            goto out;
+        }
+
         if (r == end)
             break;
 
@@ -3705,17 +4354,15 @@ term_osc8_open(struct terminal *term, uint64_t id, const char *uri)
     term_osc8_close(term);
     xassert(term->vt.osc8.uri == NULL);
 
-    term->vt.osc8.id = id;
-    term->vt.osc8.uri = xstrdup(uri);
+    term->vt.osc8.uri = grid_uri_intern(&term->uris, id, uri);
     term_update_ascii_printer(term);
 }
 
 void
 term_osc8_close(struct terminal *term)
 {
-    free(term->vt.osc8.uri);
+    grid_uri_unref(term->vt.osc8.uri);
     term->vt.osc8.uri = NULL;
-    term->vt.osc8.id = 0;
     term_update_ascii_printer(term);
 }
 
@@ -14,6 +14,7 @@
 #include <tllist.h>
 #include <fcft/fcft.h>
 
+#include "base64.h"
 #include "composed.h"
 #include "config.h"
 #include "debug.h"
@@ -96,14 +97,40 @@ enum damage_type {DAMAGE_SCROLL, DAMAGE_SCROLL_REVERSE,
 struct damage {
     enum damage_type type;
     struct scroll_region region;
-    uint16_t lines;
+    int lines;
+};
+
+/*
+ * Maximum number of pending scroll damage entries, per grid. Entries
+ * for the same region are folded (see term_damage_scroll()). When
+ * full, the entire view is damaged instead.
+ */
+#define MAX_SCROLL_DAMAGE 16
+
+/*
+ * OSC-8 URI, interned in the terminal’s URI table. All row ranges
+ * referring to the same (id, URI) pair share a single instance.
+ */
+struct row_uri {
+    uint64_t id;
+    char *uri;
+    uint64_t hash;
+    size_t ref_count;
+
+    struct uri_table *table;
+    struct row_uri *next;     /* Next in hash bucket */
+};
+
+struct uri_table {
+    struct row_uri **buckets;
+    size_t size;              /* Number of buckets; power of 2 */
+    size_t count;
 };
 
 struct row_uri_range {
     int start;
     int end;
-    uint64_t id;
-    char *uri;
+    struct row_uri *uri;
 };
 
 struct row_data {
@@ -118,6 +145,13 @@ struct row {
     struct cell *cells;
     struct row_data *extra;
 
+    /*
+     * Used width: all cells at, and after, this column are empty
+     * (wc == 0). This is an upper bound; there may be empty cells
+     * before it too. A freshly erased row has a used width of 0.
+     */
+    int used;
+
     bool dirty;
     bool linebreak;
 
@@ -145,12 +179,19 @@ struct sixel {
     struct coord pos;
     bool opaque;
 
+    /* Unique; used to find the image when an async rescale is done */
+    uint64_t id;
+
     /*
      * We store the cell dimensions of the time the sixel was emitted.
      *
      * If the font size is changed, we rescale the image accordingly,
      * to ensure it stays within its cell boundaries. ‘scaled’ is a
      * cached, rescaled version of ‘data’ + ‘pix’.
+     *
+     * ‘scaled’ is initially a (nearest-neighbor) preview, which is
+     * replaced by a high quality version once it has been scaled by
+     * the sixel scaler thread.
      */
     int cell_width;
     int cell_height;
@@ -167,6 +208,7 @@ struct sixel {
         pixman_image_t *pix;
         int width;
         int height;
+        bool preview;
     } scaled;
 };
 
@@ -203,9 +245,23 @@ struct grid {
     struct row **rows;
     struct row *cur_row;
 
-    tll(struct damage) scroll_damage;
+    struct {
+        struct damage v[MAX_SCROLL_DAMAGE];
+        size_t count;
+    } scroll_damage;
+
     tll(struct sixel) sixel_images;
 
+    /*
+     * Bitmap of the (absolute) rows covered by sixel images. Rebuilt
+     * on demand, from ‘sixel_images’; see sixel_row_has_images()
+     */
+    struct {
+        uint64_t *rows;
+        int num_rows;
+        bool valid;
+    } sixel_index;
+
     struct {
         enum kitty_kbd_flags flags[8];
         uint8_t idx;
@@ -249,12 +305,20 @@ struct vt {
         size_t size;
         size_t idx;
         bool bel; /* true if OSC string was terminated by BEL */
+
+        /* OSC 52 payload, base64 decoded as it is being received */
+        struct {
+            bool active;
+            struct base64_decoder decoder;
+            char *data;
+            size_t size;
+            size_t idx;
+        } clip;
     } osc;
 
     /* Start coordinate for current OSC-8 URI */
     struct {
-        uint64_t id;
-        char *uri;
+        struct row_uri *uri;
     } osc8;
 
     struct {
@@ -262,6 +326,8 @@ struct vt {
         size_t size;
         size_t idx;
         void (*put_handler)(struct terminal *term, uint8_t c);
+        void (*put_span_handler)(
+            struct terminal *term, const uint8_t *data, size_t len);
         void (*unhook_handler)(struct terminal *term);
     } dcs;
 };
@@ -333,6 +399,20 @@ enum overlay_style {
     OVERLAY_UNICODE_MODE,
 };
 
+/* A search match, on a single row. Columns are inclusive */
+struct search_match_span {
+    int start;
+    int end;
+};
+
+struct search_match_spans {
+    struct search_match_span *v;
+    size_t count;
+    size_t size;
+};
+
+struct search_match_cache;
+
 typedef tll(struct ptmx_buffer) ptmx_buffer_list_t;
 
 enum url_action { URL_ACTION_COPY, URL_ACTION_LAUNCH, URL_ACTION_PERSISTENT };
@@ -348,6 +428,41 @@ struct url {
 };
 typedef tll(struct url) url_list_t;
 
+/* Frame time histogram buckets: <250µs, <500µs, … <32ms, ≥32ms */
+#define TERM_STATS_FRAME_TIME_BUCKETS 9
+
+/* Runtime performance counters, see stats.c */
+struct term_stats {
+    struct {
+        uint64_t bytes;     /* Bytes fed to the VT parser */
+        uint64_t ns;        /* Time spent in the VT parser */
+        uint64_t throttled; /* PTY reads paused by flow control */
+    } parse;
+
+    struct {
+        uint64_t frames;    /* Frames rendered */
+        uint64_t deferred;  /* Refreshes deferred to a frame callback */
+        uint64_t ns;        /* Total time spent in grid_render() */
+        uint64_t max_ns;
+        uint64_t rows;      /* Total number of rows re-rendered */
+        uint64_t max_rows;  /* Max number of rows re-rendered in one frame */
+        uint64_t frame_times[TERM_STATS_FRAME_TIME_BUCKETS];
+    } render;
+
+    struct {
+        uint64_t shm;       /* Scroll damage applied with shm_scroll() */
+        uint64_t memmove;   /* Scroll damage applied with memmove() */
+    } scroll;
+
+    struct {
+        uint64_t rects;     /* Damage rectangles added by the renderer */
+        uint64_t sent;      /* Rectangles submitted, after coalescing */
+    } damage;
+};
+
+struct sixel_scale_job;
+struct font_variant_loader;
+
 struct terminal {
     struct fdm *fdm;
     struct reaper *reaper;
@@ -355,6 +470,7 @@ struct terminal {
 
     void (*ascii_printer)(struct terminal *term, char32_t c);
 
+    uint32_t id;  /* Unique (within this process) instance ID, never 0 */
     pid_t slave;
     int ptmx;
 
@@ -362,6 +478,7 @@ struct terminal {
     struct grid *grid;
     struct grid normal;
     struct grid alt;
+    struct uri_table uris;  /* OSC-8 URIs, shared by both grids */
 
     int cols;   /* number of columns */
     int rows;   /* number of rows */
@@ -398,7 +515,18 @@ struct terminal {
         int upper_fd;
     } delayed_render_timer;
 
+    /* See tweak.flow-control-budget */
+    struct {
+        uint64_t parse_ns;  /* Time spent parsing since the last frame */
+        bool paused;        /* PTY reads paused until next frame is presented */
+        bool wayl_blocked;  /* PTY reads paused until Wayland socket has drained */
+    } flow_control;
+
+    /* Regular, bold, italic, bold+italic. Only the regular font is
+     * always loaded; the others may be NULL (still loading) */
     struct fcft_font *fonts[4];
+    struct font_variant_loader *font_variant_loader;
+    uint32_t font_generation;  /* Bumped when fonts (including the CSD font) are reloaded */
     struct config_font *font_sizes[4];
     struct pt_or_px font_line_height;
     float font_dpi;
@@ -556,6 +684,8 @@ struct terminal {
             char32_t *buf;
             size_t len;
         } last;
+
+        struct search_match_cache *match_cache;
     } search;
 
     struct wayland *wl;
@@ -570,9 +700,11 @@ struct terminal {
             struct buffer_chain *search;
             struct buffer_chain *scrollback_indicator;
             struct buffer_chain *render_timer;
+            struct buffer_chain *stats;
             struct buffer_chain *url;
             struct buffer_chain *csd;
             struct buffer_chain *overlay;
+            struct buffer_chain *cursor;
         } chains;
 
         /* Scheduled for rendering, as soon-as-possible */
@@ -581,6 +713,7 @@ struct terminal {
             bool csd;
             bool search;
             bool urls;
+            bool cursor;    /* Cursor sub-surface only (e.g. blink) */
         } refresh;
 
         /* Scheduled for rendering, in the next frame callback */
@@ -593,6 +726,16 @@ struct terminal {
 
         bool margins;  /* Someone explicitly requested a refresh of the margins */
         bool urgency;  /* Signal 'urgency' (paint borders red) */
+        bool stats;    /* Show the statistics overlay */
+
+        /*
+         * Window isn’t visible; either suspended by the compositor,
+         * or starved of frame callbacks. Nothing is rendered, and
+         * blink timers are disarmed, until it is visible again
+         */
+        bool hidden;
+        bool frame_starved;
+        struct timespec frame_requested;  /* When we last requested a frame callback */
 
         struct {
             struct timespec last_update;
@@ -604,7 +747,22 @@ struct terminal {
 
         struct {
             bool enabled;
+            bool flush;             /* Render ASAP, don’t wait for frame callback */
             int timer_fd;
+            uint64_t timeout_ns;    /* Adaptive, see app_sync_updates_end() */
+            uint64_t avg_ns;        /* Moving average of window durations */
+
+            struct timespec start;  /* When the current window was opened */
+            size_t bytes;           /* Bytes received in the current window */
+
+            struct {
+                uint64_t count;     /* Number of completed windows */
+                uint64_t timeouts;  /* Windows closed by the timeout */
+                uint64_t total_ns;
+                uint64_t max_ns;
+                uint64_t bytes;
+                uint64_t max_bytes;
+            } stats;
         } app_sync_updates;
 
         /* Render threads + synchronization primitives */
@@ -618,6 +776,19 @@ struct terminal {
             struct buffer *buf;
         } workers;
 
+        /* Asynchronous, high quality, rescaling of sixel images */
+        struct {
+            bool started;
+            bool failed;  /* Couldn't start thread; scale synchronously */
+            bool quit;
+            thrd_t thread;
+            mtx_t lock;
+            cnd_t cond;
+            int event_fd;
+            tll(struct sixel_scale_job *) queue;
+            tll(struct sixel_scale_job *) done;
+        } sixel_scaler;
+
         /* Last rendered cursor position */
         struct {
             struct row *row;
@@ -625,17 +796,42 @@ struct terminal {
             bool hidden;
         } last_cursor;
 
+        /*
+         * Cursor rendered on its own sub-surface, instead of in the
+         * grid. This allows us to blink (and move) it without
+         * rendering a new grid frame.
+         */
+        struct {
+            bool active;    /* Last frame left the cursor to the sub-surface */
+            bool mapped;
+        } cursor_surface;
+
         struct buffer *last_buf;     /* Buffer we rendered to last time */
 
+        /* Saved normal screen, while the alt screen is active */
+        struct normal_screen *normal_screen;
+
+        /* Main surface damage, submitted in grid_render_end() */
+        pixman_region32_t damage;
+
         enum overlay_style last_overlay_style;
         struct buffer *last_overlay_buf;
-        pixman_region32_t last_overlay_clip;
+
+        /* Search matches, per view row, as rendered to the overlay.
+         * ‘next’ is scratch space for the frame being rendered */
+        struct {
+            struct search_match_spans *rows;
+            struct search_match_spans *next;
+            int count;
+        } last_overlay_matches;
 
         size_t search_glyph_offset;
 
         struct timespec input_time;
     } render;
 
+    struct term_stats stats;
+
     struct {
         struct grid *grid;    /* Original ‘normal’ grid, before resize started */
         int old_screen_rows;  /* term->rows before resize started */
@@ -769,6 +965,11 @@ void term_erase(
     int end_row, int end_col);
 void term_erase_scrollback(struct terminal *term);
 
+/* Memory management - see the server’s control requests */
+size_t term_scrollback_trim(struct terminal *term, int keep);
+size_t term_compact(struct terminal *term);
+size_t term_drop_caches(struct terminal *term);
+
 int term_row_rel_to_abs(const struct terminal *term, int row);
 void term_cursor_home(struct terminal *term);
 void term_cursor_to(struct terminal *term, int row, int col);
@@ -778,6 +979,9 @@ void term_cursor_right(struct terminal *term, int count);
 void term_cursor_up(struct terminal *term, int count);
 void term_cursor_down(struct terminal *term, int count);
 void term_cursor_blink_update(struct terminal *term);
+void term_visibility_update(struct terminal *term);
+void term_flow_control_resume(struct terminal *term);
+void term_flow_control_wayl_blocked(struct terminal *term, bool blocked);
 
 void term_print(struct terminal *term, char32_t wc, int width);
 
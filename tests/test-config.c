@@ -1350,6 +1350,15 @@ test_section_tweak(void)
                 &conf.tweak.max_shm_pool_size);
 #endif
 
+    test_boolean(&ctx, &parse_section_tweak, "memory-pressure",
+                 &conf.tweak.memory_pressure);
+    test_uint32(&ctx, &parse_section_tweak, "memory-pressure-scrollback-lines",
+                &conf.tweak.memory_pressure_scrollback_lines);
+    test_uint32(&ctx, &parse_section_tweak, "flow-control-budget",
+                &conf.tweak.flow_control_budget_us);
+    test_boolean(&ctx, &parse_section_tweak, "flow-control-fast-forward",
+                 &conf.tweak.flow_control_fast_forward);
+
     config_free(&conf);
 }
 
@@ -536,8 +536,8 @@ osc8_uris(const struct terminal *term, enum url_action action, url_list_t *urls)
            tll_push_back(
                *urls,
                ((struct url){
-                   .id = range->id,
-                   .url = xstrdup(range->uri),
+                   .id = range->uri->id,
+                   .url = xstrdup(range->uri->uri),
                    .range = {
                        .start = start,
                        .end = end,
@@ -805,7 +805,7 @@ urls_render(struct terminal *term)
 
     /* Clear scroll damage, to ensure we don’t apply it twice (once on
      * the snapshot:ed grid, and then later again on the real grid) */
-    tll_free(term->grid->scroll_damage);
+    term->grid->scroll_damage.count = 0;
 
     /* Damage the entire view, to ensure a full screen redraw, both
      * now, when entering URL mode, and later, when exiting it. */
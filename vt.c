@@ -213,6 +213,8 @@ action_execute(struct terminal *term, uint8_t c)
                 cell->wc = U' ';
                 cell->attrs.clean = 0;
             }
+
+            grid_row_mark_used(row, new_col);
         }
 
         /* According to the specification, HT _should_ cancel LCF. But
@@ -553,6 +555,7 @@ action_esc_dispatch(struct terminal *term, uint8_t final)
                     row->cells[c].wc = U'E';
                     row->cells[c].attrs = (struct attributes){0};
                 }
+                row->used = term->cols;
                 row->dirty = true;
             }
             break;
@@ -572,6 +575,9 @@ static void
 action_osc_start(struct terminal *term, uint8_t c)
 {
     term->vt.osc.idx = 0;
+
+    if (unlikely(term->vt.osc.clip.active))
+        osc_clipboard_reset(term);
 }
 
 static void
@@ -599,6 +605,9 @@ action_osc_put(struct terminal *term, uint8_t c)
     if (!osc_ensure_size(term, term->vt.osc.idx + 1))
         return;
     term->vt.osc.data[term->vt.osc.idx++] = c;
+
+    if (unlikely(c == ';'))
+        osc_clipboard_start(term);
 }
 
 static void
@@ -619,6 +628,137 @@ action_put(struct terminal *term, uint8_t c)
     dcs_put(term, c);
 }
 
+/*
+ * OSC and DCS strings tend to be long (OSC-52, sixel, ...), and
+ * almost all of their bytes take the same path through the state
+ * machine. The functions below find such runs, a word at a time, so
+ * that they can be handled in bulk.
+ *
+ * The word-wide tests only tell us *if* a word contains a terminating
+ * byte; the exact position is found with a byte-wise scan. This keeps
+ * them endian agnostic.
+ */
+
+#define BYTES(x) (~(uint64_t)0 / 0xff * (x))
+
+/* Number of leading bytes that are *not* C0 control characters */
+static size_t
+span_non_c0(const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t x;
+        memcpy(&x, &data[i], sizeof(x));
+
+        /* Any byte < 0x20? */
+        if ((x - BYTES(0x20)) & ~x & BYTES(0x80))
+            break;
+    }
+
+    while (i < len && data[i] >= 0x20)
+        i++;
+    return i;
+}
+
+/* Number of leading bytes that are printable ASCII (0x20-0x7e) */
+static size_t
+span_printable(const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t x;
+        memcpy(&x, &data[i], sizeof(x));
+
+        /* Any byte < 0x20, or >= 0x7f? */
+        const uint64_t lt = (x - BYTES(0x20)) & ~x;
+        const uint64_t ge = (x + BYTES(0x01)) | x;
+        if ((lt | ge) & BYTES(0x80))
+            break;
+    }
+
+    while (i < len && data[i] >= 0x20 && data[i] < 0x7f)
+        i++;
+    return i;
+}
+
+#undef BYTES
+
+UNITTEST
+{
+    const uint8_t s[] =
+        "0123456789abcdefghijklmnopqrstuvwxyz\xc3\xa5\x7f\a";
+
+    xassert(span_non_c0(s, 0) == 0);
+    xassert(span_non_c0(s, 5) == 5);
+    xassert(span_non_c0(s, sizeof(s) - 1) == sizeof(s) - 2);
+    xassert(span_non_c0((const uint8_t *)"\033", 1) == 0);
+
+    xassert(span_printable(s, 3) == 3);
+    xassert(span_printable(s, sizeof(s) - 1) == 36);
+    xassert(span_printable(&s[37], sizeof(s) - 1 - 37) == 0);
+
+    /* Terminator at every position within a word */
+    for (size_t i = 0; i < 16; i++) {
+        uint8_t buf[16];
+        memset(buf, 'A', sizeof(buf));
+
+        buf[i] = '\x18';
+        xassert(span_non_c0(buf, sizeof(buf)) == i);
+        xassert(span_printable(buf, sizeof(buf)) == i);
+
+        buf[i] = '\x9c';
+        xassert(span_non_c0(buf, sizeof(buf)) == sizeof(buf));
+        xassert(span_printable(buf, sizeof(buf)) == i);
+    }
+}
+
+/*
+ * Appends as many bytes as possible, up to the next C0 control
+ * character, to the OSC buffer. Returns the number of bytes
+ * consumed. 0 means the caller must go through the state machine.
+ */
+static size_t
+action_osc_put_span(struct terminal *term, const uint8_t *data, size_t len)
+{
+    struct vt *vt = &term->vt;
+
+    /*
+     * Let the state machine handle the OSC number, and the target
+     * list of OSC-52, since both rely on seeing each ‘;’.
+     */
+    if (vt->osc.idx < 3 || memcmp(vt->osc.data, "52;", 3) == 0)
+        return 0;
+
+    const size_t count = span_non_c0(data, len);
+    if (count <= 1)
+        return 0;
+
+    if (osc_ensure_size(term, vt->osc.idx + count)) {
+        memcpy(&vt->osc.data[vt->osc.idx], data, count);
+        vt->osc.idx += count;
+    }
+
+    return count;
+}
+
+/*
+ * Passes as many printable bytes as possible to the DCS handler.
+ * Returns the number of bytes consumed. 0 means the caller must go
+ * through the state machine.
+ */
+static size_t
+action_put_span(struct terminal *term, const uint8_t *data, size_t len)
+{
+    const size_t count = span_printable(data, len);
+    if (count <= 1)
+        return 0;
+
+    dcs_put_span(term, data, count);
+    return count;
+}
+
 static inline uint32_t
 chain_key(uint32_t old_key, uint32_t new_wc)
 {
@@ -1304,12 +1444,46 @@ vt_from_slave(struct terminal *term, const uint8_t *data, size_t len)
         case STATE_CSI_PARAM:           current_state = state_csi_param_switch(term, *p); break;
         case STATE_CSI_INTERMEDIATE:    current_state = state_csi_intermediate_switch(term, *p); break;
         case STATE_CSI_IGNORE:          current_state = state_csi_ignore_switch(term, *p); break;
-        case STATE_OSC_STRING:          current_state = state_osc_string_switch(term, *p); break;
+
+        case STATE_OSC_STRING:
+            if (unlikely(term->vt.osc.clip.active)) {
+                /* OSC 52 payload; decode as much as possible in one go */
+                size_t consumed = osc_clipboard_put(term, p, len - i);
+                if (consumed > 0) {
+                    i += consumed - 1;
+                    p += consumed - 1;
+                    break;
+                }
+            }
+
+            else {
+                size_t consumed = action_osc_put_span(term, p, len - i);
+                if (consumed > 0) {
+                    i += consumed - 1;
+                    p += consumed - 1;
+                    break;
+                }
+            }
+
+            current_state = state_osc_string_switch(term, *p);
+            break;
+
         case STATE_DCS_ENTRY:           current_state = state_dcs_entry_switch(term, *p); break;
         case STATE_DCS_PARAM:           current_state = state_dcs_param_switch(term, *p); break;
         case STATE_DCS_INTERMEDIATE:    current_state = state_dcs_intermediate_switch(term, *p); break;
         case STATE_DCS_IGNORE:          current_state = state_dcs_ignore_switch(term, *p); break;
-        case STATE_DCS_PASSTHROUGH:     current_state = state_dcs_passthrough_switch(term, *p); break;
+        case STATE_DCS_PASSTHROUGH: {
+            size_t consumed = action_put_span(term, p, len - i);
+            if (consumed > 0) {
+                i += consumed - 1;
+                p += consumed - 1;
+                break;
+            }
+
+            current_state = state_dcs_passthrough_switch(term, *p);
+            break;
+        }
+
         case STATE_SOS_PM_APC_STRING:   current_state = state_sos_pm_apc_string_switch(term, *p); break;
 
         case STATE_UTF8_21:             current_state = state_utf8_21_switch(term, *p); break;
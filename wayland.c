@@ -35,6 +35,13 @@
 #include "util.h"
 #include "xmalloc.h"
 
+/* libwayland >= 1.23 can grow the client side buffer */
+#if WAYLAND_VERSION_MAJOR > 1 || WAYLAND_VERSION_MINOR >= 23
+ #define WAYL_GROWABLE_BUFFER 1
+#else
+ #define WAYL_GROWABLE_BUFFER 0
+#endif
+
 static void
 csd_reload_font(struct wl_window *win, float old_scale)
 {
@@ -50,6 +57,7 @@ csd_reload_font(struct wl_window *win, float old_scale)
         return;
 
     fcft_destroy(win->csd.font);
+    term->font_generation++;
 
     const char *patterns[conf->csd.font.count];
     for (size_t i = 0; i < conf->csd.font.count; i++)
@@ -234,8 +242,8 @@ seat_destroy(struct seat *seat)
         wl_seat_release(seat->wl_seat);
 
     ime_reset_pending(seat);
-    free(seat->clipboard.text);
-    free(seat->primary.text);
+    selection_text_unref(seat->clipboard.text);
+    selection_text_unref(seat->primary.text);
     free(seat->pointer.last_custom_xcursor);
     free(seat->name);
 }
@@ -693,7 +701,7 @@ xdg_toplevel_configure(void *data, struct xdg_toplevel *xdg_toplevel,
     bool is_tiled_bottom = false;
     bool is_tiled_left = false;
     bool is_tiled_right = false;
-    bool is_suspended UNUSED = false;
+    bool is_suspended = false;
 
 #if defined(LOG_ENABLE_DBG) && LOG_ENABLE_DBG
     char state_str[2048];
@@ -768,6 +776,7 @@ xdg_toplevel_configure(void *data, struct xdg_toplevel *xdg_toplevel,
     win->configure.is_tiled_bottom = is_tiled_bottom;
     win->configure.is_tiled_left = is_tiled_left;
     win->configure.is_tiled_right = is_tiled_right;
+    win->configure.is_suspended = is_suspended;
     win->configure.width = width;
     win->configure.height = height;
 }
@@ -864,6 +873,7 @@ xdg_surface_configure(void *data, struct xdg_surface *xdg_surface,
                      win->is_tiled_bottom ||
                      win->is_tiled_left ||
                      win->is_tiled_right);
+    win->is_suspended = win->configure.is_suspended;
     win->csd_mode = win->configure.csd_mode;
 
     bool enable_csd = win->csd_mode == CSD_YES && !win->is_fullscreen;
@@ -909,6 +919,8 @@ xdg_surface_configure(void *data, struct xdg_surface *xdg_surface,
     else
         term_visual_focus_out(term);
 
+    term_visibility_update(term);
+
     if (!resized) {
         /*
          * If we didn't resize, we won't be committing a new surface
@@ -1026,9 +1038,12 @@ handle_global(void *data, struct wl_registry *registry,
          * adds 'tiled' window states. We use that information to
          * restore the window size when window is un-tiled. Version 5
          * adds 'wm_capabilities'. We use that information to draw
-         * window decorations.
+         * window decorations. Version 6 adds the 'suspended' state,
+         * which we use to stop rendering while not visible.
          */
-#if defined(XDG_TOPLEVEL_WM_CAPABILITIES_SINCE_VERSION)
+#if defined(XDG_TOPLEVEL_STATE_SUSPENDED_SINCE_VERSION)
+        const uint32_t preferred = XDG_TOPLEVEL_STATE_SUSPENDED_SINCE_VERSION;
+#elif defined(XDG_TOPLEVEL_WM_CAPABILITIES_SINCE_VERSION)
         const uint32_t preferred = XDG_TOPLEVEL_WM_CAPABILITIES_SINCE_VERSION;
 #elif defined(XDG_TOPLEVEL_STATE_TILED_LEFT_SINCE_VERSION)
         const uint32_t preferred = XDG_TOPLEVEL_STATE_TILED_LEFT_SINCE_VERSION;
@@ -1329,6 +1344,8 @@ static const struct wl_registry_listener registry_listener = {
     .global_remove = &handle_global_remove,
 };
 
+static void wayl_flush_blocking(struct wayland *wayl);
+
 static void
 fdm_hook(struct fdm *fdm, void *data)
 {
@@ -1342,6 +1359,16 @@ fdm_wayl(struct fdm *fdm, int fd, int events, void *data)
     struct wayland *wayl = data;
     int event_count = 0;
 
+    if (events & EPOLLOUT) {
+        /*
+         * May be stale; another wayl_flush() (e.g. from
+         * wayl_roundtrip()) may already have drained the socket, and
+         * removed the EPOLLOUT interest, in this epoll batch.
+         */
+        if (wayl->flush_blocked)
+            wayl_flush(wayl);
+    }
+
     if (events & EPOLLIN) {
         if (wl_display_read_events(wayl->display) < 0) {
             LOG_ERRNO("failed to read events from the Wayland socket");
@@ -1399,6 +1426,11 @@ wayl_init(struct fdm *fdm, struct key_binding_manager *key_binding_manager,
         goto out;
     }
 
+#if WAYL_GROWABLE_BUFFER
+    /* Let requests queue up while the socket is full (see wayl_flush()) */
+    wl_display_set_max_buffer_size(wayl->display, 0);
+#endif
+
     wayl->registry = wl_display_get_registry(wayl->display);
     if (wayl->registry == NULL) {
         LOG_ERR("failed to get wayland registry");
@@ -1588,7 +1620,7 @@ wayl_destroy(struct wayland *wayl)
     if (wayl->fd != -1)
         fdm_del_no_close(wayl->fdm, wayl->fd);
     if (wayl->display != NULL) {
-        wayl_flush(wayl);
+        wayl_flush_blocking(wayl);
         wl_display_disconnect(wayl->display);
     }
 
@@ -1754,6 +1786,16 @@ wayl_win_destroy(struct wl_window *win)
         wl_surface_commit(win->scrollback_indicator.surface.surf);
     }
 
+    if (win->cursor.surface.surf != NULL) {
+        wl_surface_attach(win->cursor.surface.surf, NULL, 0, 0);
+        wl_surface_commit(win->cursor.surface.surf);
+    }
+
+    if (win->stats.surface.surf != NULL) {
+        wl_surface_attach(win->stats.surface.surf, NULL, 0, 0);
+        wl_surface_commit(win->stats.surface.surf);
+    }
+
     /* Scrollback search */
     if (win->search.surface.surf != NULL) {
         wl_surface_attach(win->search.surface.surf, NULL, 0, 0);
@@ -1793,11 +1835,15 @@ wayl_win_destroy(struct wl_window *win)
     wayl_win_subsurface_destroy(&win->search);
     wayl_win_subsurface_destroy(&win->scrollback_indicator);
     wayl_win_subsurface_destroy(&win->render_timer);
+    wayl_win_subsurface_destroy(&win->stats);
     wayl_win_subsurface_destroy(&win->overlay);
+    wayl_win_subsurface_destroy(&win->cursor);
 
     shm_purge(term->render.chains.search);
     shm_purge(term->render.chains.scrollback_indicator);
     shm_purge(term->render.chains.render_timer);
+    shm_purge(term->render.chains.cursor);
+    shm_purge(term->render.chains.stats);
     shm_purge(term->render.chains.grid);
     shm_purge(term->render.chains.url);
     shm_purge(term->render.chains.csd);
@@ -1884,8 +1930,9 @@ wayl_reload_xcursor_theme(struct seat *seat, float new_scale)
     return true;
 }
 
-void
-wayl_flush(struct wayland *wayl)
+/* Flushes the Wayland socket, waiting for it to drain if necessary */
+static void
+wayl_flush_blocking(struct wayland *wayl)
 {
     while (true) {
         int r = wl_display_flush(wayl->display);
@@ -1930,6 +1977,75 @@ wayl_flush(struct wayland *wayl)
     }
 }
 
+void
+wayl_flush(struct wayland *wayl)
+{
+    while (true) {
+        int r = wl_display_flush(wayl->display);
+        if (r >= 0) {
+            /* Most likely code path - the flush succeed */
+            if (unlikely(wayl->flush_blocked)) {
+                LOG_DBG("Wayland socket drained");
+                fdm_event_del(wayl->fdm, wayl->fd, EPOLLOUT);
+                wayl->flush_blocked = false;
+
+                tll_foreach(wayl->terms, it)
+                    term_flow_control_wayl_blocked(it->item, false);
+            }
+            return;
+        }
+
+        if (errno == EINTR) {
+            /* Unlikely */
+            continue;
+        }
+
+        if (errno != EAGAIN) {
+            LOG_ERRNO("failed to flush wayland socket");
+            return;
+        }
+
+        /*
+         * Socket buffer is full. Instead of waiting for the
+         * compositor to drain it, let the FDM tell us when the socket
+         * is writable again (see fdm_wayl()).
+         *
+         * Until then, no new frames are rendered; refreshes are
+         * coalesced, and rendered once the socket has drained. PTY
+         * reads are paused, to bound the amount of pending state.
+         */
+        if (!wayl->flush_blocked) {
+            LOG_DBG("Wayland socket full, waiting for it to drain");
+
+            if (!fdm_event_add(wayl->fdm, wayl->fd, EPOLLOUT)) {
+                wayl_flush_blocking(wayl);
+                return;
+            }
+
+            wayl->flush_blocked = true;
+
+            tll_foreach(wayl->terms, it)
+                term_flow_control_wayl_blocked(it->item, true);
+        }
+        return;
+    }
+}
+
+void
+wayl_flush_unblock(struct wayland *wayl)
+{
+#if !WAYL_GROWABLE_BUFFER
+    if (likely(!wayl->flush_blocked))
+        return;
+
+    LOG_DBG("Wayland socket full, and buffer can't grow; blocking");
+    wayl_flush_blocking(wayl);
+
+    /* Clears the blocked state */
+    wayl_flush(wayl);
+#endif
+}
+
 void
 wayl_roundtrip(struct wayland *wayl)
 {
@@ -2169,6 +2285,9 @@ wayl_win_subsurface_destroy(struct wayl_sub_surface *surf)
         wl_surface_destroy(surf->surface.surf);
         surf->surface.surf = NULL;
     }
+
+    free(surf->osd.text);
+    surf->osd = (struct wayl_osd_cache){0};
 }
 
 #if defined(HAVE_XDG_ACTIVATION)
@@ -62,9 +62,34 @@ struct wayl_surface {
 #endif
 };
 
+/*
+ * What was last rendered to a sub-surface by render_osd(). Allows
+ * callers to skip re-rendering (and re-allocating a buffer) when the
+ * content is unchanged.
+ */
+struct wayl_osd_cache {
+    char32_t *text;
+    const struct fcft_font *font;
+    uint32_t font_generation;  /* Font pointers may be re-used after a reload */
+    enum fcft_subpixel subpixel;
+    uint32_t fg;
+    uint32_t bg;
+    int width;
+    int height;
+    float scale;
+};
+
 struct wayl_sub_surface {
     struct wayl_surface surface;
     struct wl_subsurface *sub;
+    struct wayl_osd_cache osd;
+};
+
+/* Reference counted selection data (see selection_text_new()) */
+struct selection_text {
+    char *data;
+    size_t len;
+    size_t ref_count;
 };
 
 struct wl_window;
@@ -73,7 +98,7 @@ struct wl_clipboard {
     struct wl_data_source *data_source;
     struct wl_data_offer *data_offer;
     enum data_offer_mime_type mime_type;
-    char *text;
+    struct selection_text *text;
     uint32_t serial;
 };
 
@@ -81,7 +106,7 @@ struct wl_primary {
     struct zwp_primary_selection_source_v1 *data_source;
     struct zwp_primary_selection_offer_v1 *data_offer;
     enum data_offer_mime_type mime_type;
-    char *text;
+    struct selection_text *text;
     uint32_t serial;
 };
 
@@ -395,7 +420,9 @@ struct wl_window {
     struct wayl_sub_surface search;
     struct wayl_sub_surface scrollback_indicator;
     struct wayl_sub_surface render_timer;
+    struct wayl_sub_surface stats;
     struct wayl_sub_surface overlay;
+    struct wayl_sub_surface cursor;
 
     struct wl_callback *frame_callback;
 
@@ -411,6 +438,7 @@ struct wl_window {
     bool is_tiled_left;
     bool is_tiled_right;
     bool is_tiled;  /* At least one of is_tiled_{top,bottom,left,right} is true */
+    bool is_suspended;  /* Compositor says we’re not visible */
     struct {
         int width;
         int height;
@@ -422,6 +450,7 @@ struct wl_window {
         bool is_tiled_bottom:1;
         bool is_tiled_left:1;
         bool is_tiled_right:1;
+        bool is_suspended:1;
         enum csd_mode csd_mode;
     } configure;
 
@@ -434,6 +463,7 @@ struct wayland {
     struct key_binding_manager *key_binding_manager;
 
     int fd;
+    bool flush_blocked;  /* Socket is full; waiting for EPOLLOUT */
 
     struct wl_display *display;
     struct wl_registry *registry;
@@ -487,6 +517,14 @@ bool wayl_reload_xcursor_theme(struct seat *seat, float new_scale);
 void wayl_flush(struct wayland *wayl);
 void wayl_roundtrip(struct wayland *wayl);
 
+/*
+ * Must be called before sending requests outside of frame rendering
+ * (title updates, resizes, clipboard etc). If the socket is full
+ * (see wayl_flush()), and the client side buffer can't grow, waits
+ * for it to drain, since overflowing the buffer is fatal.
+ */
+void wayl_flush_unblock(struct wayland *wayl);
+
 bool wayl_fractional_scaling(const struct wayland *wayl);
 void wayl_surface_scale(
     const struct wl_window *win, const struct wayl_surface *surf,